@@ -0,0 +1,97 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : AutoPlay.cpp
+Description : Plays a run of spins at a fixed bet without stopping at the menus, until a stop condition is met
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include "AutoPlay.h"
+#include "LivePaytable.h"
+#include "SlotSession.h"
+
+//plays the next spin of an auto play run on the headless spin path, taking the bet and paying out straight away
+//so the user's chips are right after every spin.  Returns false, with the reason set, once the run should stop -
+//either before spinning (no spins left, the bet can't be afforded, or it could win more than the user can hold)
+//or after (a win big enough to stop on).
+bool PlayAutoSpin(SlotMachineUser* _user, const AutoPlaySettings& _settings, AutoPlayProgress* _pProgress)
+{
+	int chipsNow = _user->GetChips();
+	if (_pProgress->SpinsPlayed >= _settings.SpinCount)
+	{
+		_pProgress->StopReason = EAutoPlayStop::ALL_SPINS_PLAYED;
+		return false;
+	}
+	if (_settings.Bet <= 0 || chipsNow < _settings.Bet)
+	{
+		_pProgress->StopReason = EAutoPlayStop::NOT_ENOUGH_CHIPS;
+		return false;
+	}
+	if (chipsNow - _settings.Bet < _settings.BalanceFloor)
+	{
+		_pProgress->StopReason = EAutoPlayStop::BALANCE_FLOOR;
+		return false;
+	}
+
+	const SlotPaytable& paytable = BeginPaytableRead().Paytable;
+	if (!CanPayBet(_user, _settings.Bet, paytable))
+	{
+		_pProgress->StopReason = EAutoPlayStop::WIN_TOO_BIG;
+		return false;
+	}
+	PlaceBet(_user, _settings.Bet);
+	ESpinResultCode result = SpinReels(paytable, _user->LastSpin);
+	int winnings = PayWinnings(_user, _settings.Bet, result, paytable);
+
+	_pProgress->SpinsPlayed++;
+	_pProgress->TotalBet += _settings.Bet;
+	_pProgress->TotalWon += winnings;
+	if (winnings > 0)
+	{
+		_pProgress->Wins++;
+	}
+	if (winnings > _pProgress->BiggestWin)
+	{
+		_pProgress->BiggestWin = winnings;
+	}
+
+	if (result == JACKPOT_THREE_SEVENS && _settings.StopOnJackpot)
+	{
+		_pProgress->StopReason = EAutoPlayStop::JACKPOT;
+		return false;
+	}
+	if (_settings.StopOnWinAbove > 0 && winnings > _settings.StopOnWinAbove)
+	{
+		_pProgress->StopReason = EAutoPlayStop::BIG_WIN;
+		return false;
+	}
+	return true;
+}
+
+//message shown to the user for each reason auto play can stop
+std::string DescribeAutoPlayStop(EAutoPlayStop _eReason)
+{
+	switch (_eReason)
+	{
+	case EAutoPlayStop::ALL_SPINS_PLAYED:
+		return "All the spins were played.";
+	case EAutoPlayStop::BALANCE_FLOOR:
+		return "Another bet would have taken your chips below the limit you set.";
+	case EAutoPlayStop::BIG_WIN:
+		return "You had a win bigger than the amount you chose to stop at!";
+	case EAutoPlayStop::JACKPOT:
+		return "You hit the jackpot!";
+	case EAutoPlayStop::NOT_ENOUGH_CHIPS:
+		return "You don't have enough chips left for another bet.";
+	case EAutoPlayStop::WIN_TOO_BIG:
+		return "Another bet could have won more chips than you can hold.";
+	case EAutoPlayStop::CANCELLED:
+		return "You stopped auto play.";
+	default:
+		return "Auto play is still going.";
+	}
+}
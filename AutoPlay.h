@@ -0,0 +1,57 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : AutoPlay.h
+Description : Plays a run of spins at a fixed bet without stopping at the menus, until a stop condition is met
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <string>
+
+#include "SlotEngine.h"
+#include "SlotMachineUser.h"
+
+const int AUTO_PLAY_REFRESHES_PER_SECOND = 4; //most times a second the screen is redrawn while auto play runs
+
+//why an auto play run stopped
+enum class EAutoPlayStop
+{
+	STILL_PLAYING,
+	ALL_SPINS_PLAYED,
+	BALANCE_FLOOR,
+	BIG_WIN,
+	JACKPOT,
+	NOT_ENOUGH_CHIPS,
+	WIN_TOO_BIG,
+	CANCELLED,
+};
+
+//what the player asked for.  A floor or win limit of 0 means no limit.
+struct AutoPlaySettings
+{
+	int SpinCount = 0;
+	int Bet = 0;
+	int BalanceFloor = 0; //never bets if it would take the chips below this
+	int StopOnWinAbove = 0; //stops after any single win of more than this
+	bool StopOnJackpot = true;
+};
+
+//running totals for the display, kept up to date after every spin
+struct AutoPlayProgress
+{
+	int SpinsPlayed = 0;
+	long long TotalBet = 0;
+	long long TotalWon = 0;
+	int Wins = 0;
+	int BiggestWin = 0;
+	EAutoPlayStop StopReason = EAutoPlayStop::STILL_PLAYING;
+};
+
+bool PlayAutoSpin(SlotMachineUser* _user, const AutoPlaySettings& _settings, AutoPlayProgress* _pProgress);
+std::string DescribeAutoPlayStop(EAutoPlayStop _eReason);
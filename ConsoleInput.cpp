@@ -0,0 +1,199 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : ConsoleInput.cpp
+Description : Reads the keyboard a key at a time, so menus answer on the keypress and amounts are edited in place
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <windows.h>
+#include <conio.h>
+#include <chrono>
+#include <iostream>
+
+#include "ConsoleInput.h"
+#include "SystemHelpers.h"
+
+const DWORD KEY_WAIT_MILLISECONDS = 50; //longest WaitForKey sleeps between checks - it wakes straight away when a key arrives
+
+static DWORD g_savedConsoleMode = 0; //console input mode from before raw input started, put back when it stops
+static bool g_isRawInput = false;
+static KeyLatencyStats g_keyLatency;
+static std::chrono::steady_clock::time_point g_keySignalledTime; //when the console input last woke WaitForKey
+
+//turns off line input and echo, so each key reaches the game the moment it is pressed and the game decides what to show.
+//ctrl+c still works.  Returns false if the console mode couldn't be changed (e.g. input is redirected from a file).
+bool StartRawConsoleInput()
+{
+	if (g_isRawInput)
+	{
+		return true;
+	}
+
+	HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+	if (!GetConsoleMode(input, &g_savedConsoleMode))
+	{
+		return false;
+	}
+	if (!SetConsoleMode(input, g_savedConsoleMode & ~(DWORD)(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT)))
+	{
+		return false;
+	}
+	g_isRawInput = true;
+
+	CleanUpAtExit(StopRawConsoleInput);
+	return true;
+}
+
+//puts the console back to reading whole lines
+void StopRawConsoleInput()
+{
+	if (g_isRawInput)
+	{
+		SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), g_savedConsoleMode);
+		g_isRawInput = false;
+	}
+	return;
+}
+
+//gives back the next key if one has been pressed, or KEY_NONE straight away if not.
+//arrow and function keys come through as two codes, they aren't used so both halves are skipped.
+int PollKey()
+{
+	while (_kbhit())
+	{
+		int key = _getch();
+		if (key == 0 || key == 0xE0)
+		{
+			_getch();
+			continue;
+		}
+		return key;
+	}
+	return KEY_NONE;
+}
+
+//throws away anything at the front of the console input that isn't a key press with a character - key releases, shift
+//and the other modifiers, mouse, focus and resize events.  _kbhit looks past these without removing them, so left alone
+//they keep the input handle signalled and WaitForKey would spin instead of sleeping.
+static void DiscardNonCharacterInput(HANDLE _input)
+{
+	INPUT_RECORD record;
+	DWORD eventsRead = 0;
+	while (PeekConsoleInputA(_input, &record, 1, &eventsRead) && eventsRead == 1)
+	{
+		if (record.EventType == KEY_EVENT && record.Event.KeyEvent.bKeyDown && record.Event.KeyEvent.uChar.AsciiChar != 0)
+		{
+			return;
+		}
+		ReadConsoleInputA(_input, &record, 1, &eventsRead);
+	}
+	return;
+}
+
+//waits for the next key.  Rather than sleeping for a fixed time between checks it waits on the console input handle,
+//which wakes up as soon as anything arrives, so a key is picked up within a fraction of a millisecond.
+//the time the handle last woke the wait is kept for the latency stats.  A key typed ahead, before the game started
+//waiting, is timed from when the game got to it, as there's no way to tell when it was really pressed.
+int WaitForKey()
+{
+	HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+	g_keySignalledTime = std::chrono::steady_clock::now();
+	int key = PollKey();
+	while (key == KEY_NONE)
+	{
+		DiscardNonCharacterInput(input);
+		if (WaitForSingleObject(input, KEY_WAIT_MILLISECONDS) == WAIT_OBJECT_0)
+		{
+			g_keySignalledTime = std::chrono::steady_clock::now();
+		}
+		key = PollKey();
+	}
+	return key;
+}
+
+//flushes whatever was echoed for a key, and counts how long it took from the console signalling the key
+static void FinishKeyEcho()
+{
+	std::cout.flush();
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - g_keySignalledTime).count();
+	g_keyLatency.KeysTimed++;
+	g_keyLatency.LastMilliseconds = milliseconds;
+	g_keyLatency.TotalMilliseconds += milliseconds;
+	if (milliseconds > g_keyLatency.WorstMilliseconds)
+	{
+		g_keyLatency.WorstMilliseconds = milliseconds;
+	}
+	return;
+}
+
+//takes a single key as a menu answer, without waiting for enter.
+//gives back the key as a one character string (or an empty one for enter), so it can be checked just like a typed line
+std::string ReadKeyChoice()
+{
+	int key = WaitForKey();
+
+	std::string choice;
+	if (key != KEY_ENTER && key >= ' ' && key < 127)
+	{
+		choice = (char)key;
+	}
+	else if (key != KEY_ENTER)
+	{
+		choice = "?"; //a control key, which is never a valid answer
+	}
+	std::cout << choice << "\n  ";
+	FinishKeyEcho();
+	return choice;
+}
+
+//lets the user type an amount on the current line, echoing each key as it is pressed.  Backspace rubs out the
+//last character, escape clears the lot, and enter finishes.  Only the characters that change are redrawn.
+//anything printable is accepted, so a mistyped amount still gets the usual error message once enter is pressed.
+std::string ReadAmountInPlace(int _iMaxLength)
+{
+	std::string amount;
+	while (true)
+	{
+		int key = WaitForKey();
+
+		if (key == KEY_ENTER)
+		{
+			std::cout << "\n  ";
+			FinishKeyEcho();
+			return amount;
+		}
+		else if (key == KEY_BACKSPACE)
+		{
+			if (!amount.empty())
+			{
+				amount.pop_back();
+				std::cout << "\b \b";
+			}
+		}
+		else if (key == KEY_ESCAPE)
+		{
+			for (size_t i = 0; i < amount.size(); ++i)
+			{
+				std::cout << "\b \b";
+			}
+			amount.clear();
+		}
+		else if (key >= ' ' && key < 127 && (int)amount.size() < _iMaxLength)
+		{
+			amount += (char)key;
+			std::cout << (char)key;
+		}
+		FinishKeyEcho();
+	}
+}
+
+//how quickly key presses have been showing up on screen so far
+KeyLatencyStats GetKeyLatencyStats()
+{
+	return g_keyLatency;
+}
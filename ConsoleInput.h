@@ -0,0 +1,38 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : ConsoleInput.h
+Description : Reads the keyboard a key at a time, so menus answer on the keypress and amounts are edited in place
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <string>
+
+const int KEY_NONE = -1; //no key waiting
+const int KEY_ENTER = '\r';
+const int KEY_BACKSPACE = '\b';
+const int KEY_ESCAPE = 27;
+const int MAX_AMOUNT_LENGTH = 9; //longest amount that can be typed, so it always fits in an int
+
+//how quickly key presses show up on screen, from the console input signalling the key to its echo being flushed
+struct KeyLatencyStats
+{
+	long long KeysTimed = 0;
+	double LastMilliseconds = 0.0;
+	double WorstMilliseconds = 0.0;
+	double TotalMilliseconds = 0.0;
+};
+
+bool StartRawConsoleInput();
+void StopRawConsoleInput();
+int PollKey();
+int WaitForKey();
+std::string ReadKeyChoice();
+std::string ReadAmountInPlace(int _iMaxLength = MAX_AMOUNT_LENGTH);
+KeyLatencyStats GetKeyLatencyStats();
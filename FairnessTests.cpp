@@ -0,0 +1,494 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : FairnessTests.cpp
+Description : Statistical tests that the reels land as the paytable's weights say and are independent, run over billions of draws
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "FairnessTests.h"
+#include "LivePaytable.h"
+#include "SecureRandom.h"
+#include "SlotEngine.h"
+#include "SystemHelpers.h"
+
+const int GAP_TEST_BINS = 40; //gaps of 0 to 38 non-7s get their own bin, the last bin holds anything longer
+const int SPINS_PER_BATCH = 1 << 20; //spins a thread does before checking for more work
+const double MIN_EXPECTED_COUNT = 5.0; //bins expected fewer times than this are pooled into one, as chi-square is unreliable on tiny counts
+
+//counts gathered by each thread, merged together at the end
+struct FairnessCounts
+{
+	long long ValueCounts[REEL_COUNT][REEL_SYMBOL_COUNT] = {}; //how often each value landed on each reel
+	long long SerialPairs[REEL_COUNT][REEL_SYMBOL_COUNT][REEL_SYMBOL_COUNT] = {}; //value on a reel, then its value on the next spin
+	long long ReelPairs[REEL_COUNT][REEL_SYMBOL_COUNT][REEL_SYMBOL_COUNT] = {}; //reel a value, reel b value, for the pairs (0,1) (0,2) (1,2)
+	long long Triples[REEL_SYMBOL_COUNT][REEL_SYMBOL_COUNT][REEL_SYMBOL_COUNT] = {}; //all three reels together
+	long long GapCounts[REEL_COUNT][GAP_TEST_BINS] = {}; //spins between one 7 and the next on each reel
+	long long ResultCounts[4] = {}; //losing, two match, three match, jackpot
+	uint64_t PaytableVersion = 0; //version of the live paytable the thread spun on
+
+	//runs test of low (2-4) against high (5-7) values.  Each thread is its own stream, so the expected
+	//number of runs and its variance are worked out per stream and added together.
+	double RunsObserved[REEL_COUNT] = {};
+	double RunsExpected[REEL_COUNT] = {};
+	double RunsVariance[REEL_COUNT] = {};
+};
+
+//regularized upper incomplete gamma function Q(a, x), using a series when x is small and a continued fraction otherwise
+static double GetUpperIncompleteGamma(double _dA, double _dX)
+{
+	if (_dX <= 0.0)
+	{
+		return 1.0;
+	}
+
+	const int MAX_ITERATIONS = 1000;
+	const double EPSILON = 1e-15;
+	double logPrefix = -_dX + _dA * std::log(_dX) - std::lgamma(_dA);
+
+	if (_dX < _dA + 1.0)
+	{
+		double term = 1.0 / _dA;
+		double sum = term;
+		for (int n = 1; n < MAX_ITERATIONS; ++n)
+		{
+			term *= _dX / (_dA + n);
+			sum += term;
+			if (std::fabs(term) < std::fabs(sum) * EPSILON)
+			{
+				break;
+			}
+		}
+		return 1.0 - sum * std::exp(logPrefix);
+	}
+	else
+	{
+		//Lentz's method for the continued fraction
+		const double TINY = 1e-300;
+		double b = _dX + 1.0 - _dA;
+		double c = 1.0 / TINY;
+		double d = 1.0 / b;
+		double h = d;
+		for (int n = 1; n < MAX_ITERATIONS; ++n)
+		{
+			double an = -n * (n - _dA);
+			b += 2.0;
+			d = an * d + b;
+			if (std::fabs(d) < TINY)
+			{
+				d = TINY;
+			}
+			c = b + an / c;
+			if (std::fabs(c) < TINY)
+			{
+				c = TINY;
+			}
+			d = 1.0 / d;
+			double delta = d * c;
+			h *= delta;
+			if (std::fabs(delta - 1.0) < EPSILON)
+			{
+				break;
+			}
+		}
+		return std::exp(logPrefix) * h;
+	}
+}
+
+//chance of a chi-square value at least this large if the reels really are fair
+double GetChiSquarePValue(double _dChiSquare, int _iDegreesOfFreedom)
+{
+	return GetUpperIncompleteGamma(_iDegreesOfFreedom / 2.0, _dChiSquare / 2.0);
+}
+
+//two sided chance of a z score at least this far from 0 if the reels really are fair
+double GetNormalPValue(double _dZScore)
+{
+	return std::erfc(std::fabs(_dZScore) / std::sqrt(2.0));
+}
+
+//adds a chi-square test to the report, given observed counts and the chance of landing in each bin.
+//a paytable can give a value no weight, so bins that can't be landed in are left out - and anything landing in one fails.
+//it can also make some bins very unlikely (long gaps between 7s when 7 is heavily weighted), so those are pooled together.
+static void AddChiSquareResult(FairnessReport& _report, const std::string& _strName, const long long* _pObserved, const double* _pExpectedChance, int _iBins)
+{
+	long long total = 0;
+	for (int i = 0; i < _iBins; ++i)
+	{
+		total += _pObserved[i];
+	}
+
+	FairnessTestResult result;
+	result.Name = _strName;
+	int binsUsed = 0;
+	bool landedInImpossibleBin = false;
+	double pooledObserved = 0.0;
+	double pooledExpected = 0.0;
+	for (int i = 0; i < _iBins; ++i)
+	{
+		double expected = total * _pExpectedChance[i];
+		if (expected <= 0.0)
+		{
+			landedInImpossibleBin = landedInImpossibleBin || _pObserved[i] > 0;
+			continue;
+		}
+		if (expected < MIN_EXPECTED_COUNT)
+		{
+			pooledObserved += _pObserved[i];
+			pooledExpected += expected;
+			continue;
+		}
+		double difference = _pObserved[i] - expected;
+		result.Statistic += difference * difference / expected;
+		binsUsed++;
+	}
+	if (pooledExpected > 0.0)
+	{
+		double difference = pooledObserved - pooledExpected;
+		result.Statistic += difference * difference / pooledExpected;
+		binsUsed++;
+	}
+	result.DegreesOfFreedom = binsUsed > 1 ? binsUsed - 1 : 1;
+
+	if (landedInImpossibleBin)
+	{
+		result.PValue = 0.0;
+		result.Passed = false;
+	}
+	else if (binsUsed < 2) //only one outcome can happen, so there is nothing to test
+	{
+		result.PValue = 0.5;
+		result.Passed = true;
+	}
+	else
+	{
+		result.PValue = GetChiSquarePValue(result.Statistic, result.DegreesOfFreedom);
+		result.Passed = result.PValue >= FAIRNESS_SIGNIFICANCE && result.PValue <= 1.0 - FAIRNESS_SIGNIFICANCE;
+	}
+	_report.Results.push_back(result);
+	return;
+}
+
+//adds a test scored with a z score to the report
+static void AddNormalResult(FairnessReport& _report, const std::string& _strName, double _dZScore)
+{
+	FairnessTestResult result;
+	result.Name = _strName;
+	result.Statistic = _dZScore;
+	result.PValue = GetNormalPValue(_dZScore);
+	result.Passed = result.PValue >= FAIRNESS_SIGNIFICANCE;
+	_report.Results.push_back(result);
+	return;
+}
+
+//spins the reels over and over on one thread, counting everything the tests need
+static void RunFairnessWorker(FairnessCounts* _pCounts, std::atomic<long long>* _pSpinsLeft, EFairnessDrawPath _eDrawPath)
+{
+	ChaCha20Generator generator;
+	if (_eDrawPath == EFairnessDrawPath::GENERATOR_ONLY && !generator.SeedFromSystem())
+	{
+		return;
+	}
+
+	//the thread never reads the paytable again, so this version stays valid for the whole run
+	const PublishedPaytable& published = BeginPaytableRead();
+	const SlotPaytable& paytable = published.Paytable;
+	_pCounts->PaytableVersion = published.Version;
+
+	const int reelPairs[REEL_COUNT][2] = { { 0,1 }, { 0,2 }, { 1,2 } };
+	int lastValue[REEL_COUNT];
+	long long spinsSinceSeven[REEL_COUNT];
+	bool seenSeven[REEL_COUNT] = { false, false, false };
+	bool lastWasHigh[REEL_COUNT];
+	long long lowCount[REEL_COUNT] = { 0 };
+	long long highCount[REEL_COUNT] = { 0 };
+	long long runCount[REEL_COUNT] = { 0 };
+	bool isFirstSpin = true;
+
+	while (true)
+	{
+		long long batch = _pSpinsLeft->fetch_sub(SPINS_PER_BATCH);
+		if (batch <= 0)
+		{
+			break;
+		}
+		if (batch > SPINS_PER_BATCH)
+		{
+			batch = SPINS_PER_BATCH;
+		}
+
+		for (long long spin = 0; spin < batch; ++spin)
+		{
+			int slotNums[REEL_COUNT];
+			int value[REEL_COUNT];
+			for (int r = 0; r < REEL_COUNT; ++r)
+			{
+				if (_eDrawPath == EFairnessDrawPath::SPIN_PATH)
+				{
+					slotNums[r] = SpinReel(paytable);
+				}
+				else
+				{
+					slotNums[r] = SpinReel(paytable, generator);
+				}
+				value[r] = slotNums[r] - REEL_MIN_VALUE;
+			}
+
+			for (int r = 0; r < REEL_COUNT; ++r)
+			{
+				_pCounts->ValueCounts[r][value[r]]++;
+
+				bool isHigh = value[r] >= REEL_SYMBOL_COUNT / 2;
+				if (isHigh)
+				{
+					highCount[r]++;
+				}
+				else
+				{
+					lowCount[r]++;
+				}
+
+				if (!isFirstSpin)
+				{
+					_pCounts->SerialPairs[r][lastValue[r]][value[r]]++;
+					if (isHigh != lastWasHigh[r])
+					{
+						runCount[r]++;
+					}
+				}
+				else
+				{
+					runCount[r] = 1;
+				}
+				lastValue[r] = value[r];
+				lastWasHigh[r] = isHigh;
+
+				if (slotNums[r] == REEL_MAX_VALUE)
+				{
+					if (seenSeven[r])
+					{
+						long long gap = spinsSinceSeven[r] < GAP_TEST_BINS - 1 ? spinsSinceSeven[r] : GAP_TEST_BINS - 1;
+						_pCounts->GapCounts[r][gap]++;
+					}
+					seenSeven[r] = true;
+					spinsSinceSeven[r] = 0;
+				}
+				else
+				{
+					spinsSinceSeven[r]++;
+				}
+
+				_pCounts->ReelPairs[r][value[reelPairs[r][0]]][value[reelPairs[r][1]]]++;
+			}
+			_pCounts->Triples[value[0]][value[1]][value[2]]++;
+
+			switch (GetSpinResultCode(slotNums))
+			{
+			case LOSING_SPIN:
+				_pCounts->ResultCounts[0]++;
+				break;
+			case TWO_NUMS_MATCH:
+				_pCounts->ResultCounts[1]++;
+				break;
+			case THREE_NUMS_MATCH:
+				_pCounts->ResultCounts[2]++;
+				break;
+			case JACKPOT_THREE_SEVENS:
+				_pCounts->ResultCounts[3]++;
+				break;
+			}
+			isFirstSpin = false;
+		}
+	}
+
+	//expected runs and variance for this thread's stream (Wald-Wolfowitz)
+	for (int r = 0; r < REEL_COUNT; ++r)
+	{
+		double n1 = (double)lowCount[r];
+		double n2 = (double)highCount[r];
+		double n = n1 + n2;
+		if (n < 2)
+		{
+			continue;
+		}
+		_pCounts->RunsObserved[r] = (double)runCount[r];
+		_pCounts->RunsExpected[r] = 2.0 * n1 * n2 / n + 1.0;
+		_pCounts->RunsVariance[r] = 2.0 * n1 * n2 * (2.0 * n1 * n2 - n) / (n * n * (n - 1.0));
+	}
+	return;
+}
+
+//spins the reels the given number of times across every core, on the live paytable, and checks every value lands
+//as often as its weight says and the reels are independent:
+//  chi-square of each reel's values, serial pairs and gaps between 7s on each reel, pairs of reels, all three reels,
+//  and the win/loss results against their exact chances, plus serial correlation and runs tests on each reel.
+//on the spin path every test thread takes from the one shared buffer, so it is slower, but it tests what the game really draws.
+//the paytable mustn't change during the run (stop the paytable watcher first) - a thread that spun on another version fails the run.
+FairnessReport RunFairnessTests(long long _iSpinCount, int _iThreadCount, EFairnessDrawPath _eDrawPath)
+{
+	FairnessReport report;
+	report.DrawPath = _eDrawPath;
+	const PublishedPaytable& tested = BeginPaytableRead();
+	report.Paytable = tested.Paytable;
+	report.PaytableVersion = tested.Version;
+	long long fallbacksBefore = GetSecureRandomFallbackCount();
+	auto startTime = std::chrono::steady_clock::now();
+
+	_iThreadCount = GetWorkerThreadCount(_iThreadCount);
+	report.ThreadsUsed = _iThreadCount;
+
+	std::vector<FairnessCounts> threadCounts(_iThreadCount);
+	std::atomic<long long> spinsLeft(_iSpinCount);
+	std::vector<std::thread> workers;
+	for (int i = 0; i < _iThreadCount; ++i)
+	{
+		workers.push_back(std::thread(RunFairnessWorker, &threadCounts[i], &spinsLeft, _eDrawPath));
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	report.FallbackDraws = GetSecureRandomFallbackCount() - fallbacksBefore;
+
+	//merge every thread's counts
+	FairnessCounts total;
+	double runsObserved[REEL_COUNT] = { 0 };
+	double runsExpected[REEL_COUNT] = { 0 };
+	double runsVariance[REEL_COUNT] = { 0 };
+	for (const FairnessCounts& counts : threadCounts)
+	{
+		for (int r = 0; r < REEL_COUNT; ++r)
+		{
+			for (int a = 0; a < REEL_SYMBOL_COUNT; ++a)
+			{
+				total.ValueCounts[r][a] += counts.ValueCounts[r][a];
+				for (int b = 0; b < REEL_SYMBOL_COUNT; ++b)
+				{
+					total.SerialPairs[r][a][b] += counts.SerialPairs[r][a][b];
+					total.ReelPairs[r][a][b] += counts.ReelPairs[r][a][b];
+				}
+			}
+			for (int g = 0; g < GAP_TEST_BINS; ++g)
+			{
+				total.GapCounts[r][g] += counts.GapCounts[r][g];
+			}
+			runsObserved[r] += counts.RunsObserved[r];
+			runsExpected[r] += counts.RunsExpected[r];
+			runsVariance[r] += counts.RunsVariance[r];
+		}
+		for (int a = 0; a < REEL_SYMBOL_COUNT; ++a)
+		{
+			for (int b = 0; b < REEL_SYMBOL_COUNT; ++b)
+			{
+				for (int c = 0; c < REEL_SYMBOL_COUNT; ++c)
+				{
+					total.Triples[a][b][c] += counts.Triples[a][b][c];
+				}
+			}
+		}
+		for (int i = 0; i < 4; ++i)
+		{
+			total.ResultCounts[i] += counts.ResultCounts[i];
+			report.SpinsTested += counts.ResultCounts[i];
+		}
+	}
+
+	//chances each bin should have if the reels are fair, from the tested paytable's weights
+	double valueChance[REEL_SYMBOL_COUNT];
+	double pairChance[REEL_SYMBOL_COUNT * REEL_SYMBOL_COUNT];
+	double tripleChance[REEL_SYMBOL_COUNT * REEL_SYMBOL_COUNT * REEL_SYMBOL_COUNT];
+	double gapChance[GAP_TEST_BINS];
+	int totalWeight = 0;
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		totalWeight += report.Paytable.ReelWeights[i];
+	}
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		valueChance[i] = (double)report.Paytable.ReelWeights[i] / totalWeight;
+	}
+	for (int a = 0; a < REEL_SYMBOL_COUNT; ++a)
+	{
+		for (int b = 0; b < REEL_SYMBOL_COUNT; ++b)
+		{
+			pairChance[a * REEL_SYMBOL_COUNT + b] = valueChance[a] * valueChance[b];
+			for (int c = 0; c < REEL_SYMBOL_COUNT; ++c)
+			{
+				tripleChance[(a * REEL_SYMBOL_COUNT + b) * REEL_SYMBOL_COUNT + c] = valueChance[a] * valueChance[b] * valueChance[c];
+			}
+		}
+	}
+	double sevenChance = valueChance[REEL_MAX_VALUE - REEL_MIN_VALUE];
+	for (int g = 0; g < GAP_TEST_BINS - 1; ++g)
+	{
+		gapChance[g] = std::pow(1.0 - sevenChance, g) * sevenChance;
+	}
+	gapChance[GAP_TEST_BINS - 1] = std::pow(1.0 - sevenChance, GAP_TEST_BINS - 1);
+
+	const char* reelPairNames[REEL_COUNT] = { "1 and 2", "1 and 3", "2 and 3" };
+	for (int r = 0; r < REEL_COUNT; ++r)
+	{
+		std::string reelName = "Reel " + std::to_string(r + 1);
+		AddChiSquareResult(report, reelName + " value frequency", total.ValueCounts[r], valueChance, REEL_SYMBOL_COUNT);
+		AddChiSquareResult(report, reelName + " serial pairs", &total.SerialPairs[r][0][0], pairChance, REEL_SYMBOL_COUNT * REEL_SYMBOL_COUNT);
+		AddChiSquareResult(report, reelName + " gaps between 7s", total.GapCounts[r], gapChance, GAP_TEST_BINS);
+
+		//lag 1 serial correlation worked out from the serial pair counts.  Under the null hypothesis sqrt(n) * r is standard normal.
+		double n = 0, sumX = 0, sumY = 0, sumXX = 0, sumYY = 0, sumXY = 0;
+		for (int a = 0; a < REEL_SYMBOL_COUNT; ++a)
+		{
+			for (int b = 0; b < REEL_SYMBOL_COUNT; ++b)
+			{
+				double count = (double)total.SerialPairs[r][a][b];
+				n += count;
+				sumX += count * a;
+				sumY += count * b;
+				sumXX += count * a * a;
+				sumYY += count * b * b;
+				sumXY += count * a * b;
+			}
+		}
+		double covariance = sumXY / n - (sumX / n) * (sumY / n);
+		double spread = std::sqrt((sumXX / n - (sumX / n) * (sumX / n)) * (sumYY / n - (sumY / n) * (sumY / n)));
+		AddNormalResult(report, reelName + " serial correlation", spread > 0 ? covariance / spread * std::sqrt(n) : 0.0);
+
+		double runsZ = runsVariance[r] > 0 ? (runsObserved[r] - runsExpected[r]) / std::sqrt(runsVariance[r]) : 0.0;
+		AddNormalResult(report, reelName + " runs of low (" + std::to_string(REEL_MIN_VALUE) + "-" + std::to_string(REEL_MIN_VALUE + REEL_SYMBOL_COUNT / 2 - 1)
+			+ ") and high (" + std::to_string(REEL_MIN_VALUE + REEL_SYMBOL_COUNT / 2) + "-" + std::to_string(REEL_MAX_VALUE) + ")", runsZ);
+	}
+
+	for (int r = 0; r < REEL_COUNT; ++r)
+	{
+		AddChiSquareResult(report, std::string("Reels ") + reelPairNames[r] + " independence", &total.ReelPairs[r][0][0], pairChance, REEL_SYMBOL_COUNT * REEL_SYMBOL_COUNT);
+	}
+	AddChiSquareResult(report, "All three reels together", &total.Triples[0][0][0], tripleChance, REEL_SYMBOL_COUNT * REEL_SYMBOL_COUNT * REEL_SYMBOL_COUNT);
+
+	ResultChances chances = GetResultChances(report.Paytable.ReelWeights);
+	double resultChance[4] = { 1.0 - chances.TwoMatch - chances.ThreeMatch - chances.Jackpot, chances.TwoMatch, chances.ThreeMatch, chances.Jackpot };
+	AddChiSquareResult(report, "Spin results against exact chances", total.ResultCounts, resultChance, 4);
+
+	//the chances above are only right if every thread spun on the paytable they were worked out from
+	report.AllOnTestedPaytable = true;
+	for (const FairnessCounts& counts : threadCounts)
+	{
+		report.AllOnTestedPaytable = report.AllOnTestedPaytable && counts.PaytableVersion == report.PaytableVersion;
+	}
+
+	report.AllPassed = report.AllOnTestedPaytable;
+	for (const FairnessTestResult& result : report.Results)
+	{
+		report.AllPassed = report.AllPassed && result.Passed;
+	}
+
+	report.SecondsTaken = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return report;
+}
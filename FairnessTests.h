@@ -0,0 +1,57 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : FairnessTests.h
+Description : Statistical tests that the reels land as the paytable's weights say and are independent, run over billions of draws
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SlotEngine.h"
+
+//where the tests draw their reel values from
+enum class EFairnessDrawPath
+{
+	GENERATOR_ONLY, //straight from a generator on each test thread, at the generator's full speed.  Covers the generator, range reduction and SpinReel.
+	SPIN_PATH, //through GetSecureRandomNumber like a real spin.  Every draw is claimed from the one shared buffer, so it is far slower.
+};
+
+//outcome of one statistical test
+struct FairnessTestResult
+{
+	std::string Name;
+	double Statistic = 0.0; //chi-square value, or z score for the normal tests
+	int DegreesOfFreedom = 0; //0 for tests scored with a z score
+	double PValue = 0.0;
+	bool Passed = false;
+};
+
+//all the test results from a fairness run
+struct FairnessReport
+{
+	std::vector<FairnessTestResult> Results;
+	long long SpinsTested = 0;
+	double SecondsTaken = 0.0;
+	int ThreadsUsed = 0;
+	EFairnessDrawPath DrawPath = EFairnessDrawPath::GENERATOR_ONLY;
+	SlotPaytable Paytable; //the live paytable the reels were spun on, and the expected chances worked out from
+	uint64_t PaytableVersion = 0;
+	bool AllOnTestedPaytable = false; //no thread spun on a different version, which would make the expected chances wrong
+	long long FallbackDraws = 0; //words generated on a test thread because the shared buffer was empty (spin path only)
+	bool AllPassed = false;
+};
+
+const double FAIRNESS_SIGNIFICANCE = 0.0001; //a test fails if its p-value is below this, or above 1 minus this
+
+FairnessReport RunFairnessTests(long long _iSpinCount, int _iThreadCount = 0, EFairnessDrawPath _eDrawPath = EFairnessDrawPath::GENERATOR_ONLY);
+double GetChiSquarePValue(double _dChiSquare, int _iDegreesOfFreedom);
+double GetNormalPValue(double _dZScore);
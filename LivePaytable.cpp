@@ -0,0 +1,490 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : LivePaytable.cpp
+Description : The paytable spins are played on, which can be swapped for a new one while sessions are spinning
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "LivePaytable.h"
+#include "SystemHelpers.h"
+
+//How swapping works (read-copy-update, with quiescent states):
+//  Every spin starts with BeginPaytableRead, which loads the current paytable pointer and hands back that version.
+//  The version stays valid for the whole spin, even if a new one is published part way through.
+//  Each thread that reads has a reader slot, and BeginPaytableRead also records in it the publish count it has seen,
+//  which promises the thread has let go of whatever version it was given before.
+//  Publishing swaps the pointer and puts the old version on a retired list.  A retired version is only freed
+//  once every reader has recorded a publish count at or past the one that retired it.
+//So a spin is one atomic load and one atomic store of the thread's own slot - no locks or read-modify-writes.
+//Registering a thread, publishing and freeing take a lock, but they are rare.
+
+//one reading thread's slot.  Slots are never freed, a thread that exits hands its slot on to the next new thread.
+struct PaytableReader
+{
+	std::atomic<uint64_t> SeenPublishCount{ 0 };
+	bool InUse = false; //only touched while holding g_paytableLock
+	char Padding[64]; //keeps each reader's slot off its neighbour's cache line
+};
+
+//a replaced version, waiting until no reader can still be using it
+struct RetiredPaytable
+{
+	const PublishedPaytable* Paytable;
+	uint64_t RetiredAtPublishCount;
+};
+
+//the paytable in play until another is published, with its statistics worked out the same way as a published one
+static PublishedPaytable MakeBuiltInPaytable()
+{
+	PublishedPaytable builtIn;
+	builtIn.Stats = EvaluatePaytable(builtIn.Paytable);
+	return builtIn;
+}
+
+static const PublishedPaytable g_builtInPaytable = MakeBuiltInPaytable(); //never freed, it isn't on the heap
+static std::atomic<const PublishedPaytable*> g_pCurrentPaytable(&g_builtInPaytable);
+static std::atomic<uint64_t> g_paytablePublishCount(0);
+static std::mutex g_paytableLock; //guards everything below, and publishing
+static std::vector<PaytableReader*> g_paytableReaders;
+static std::vector<RetiredPaytable> g_retiredPaytables;
+static uint64_t g_lastPaytableVersion = 1;
+static long long g_paytablesFreed = 0;
+
+//gives the calling thread a reader slot
+static PaytableReader* RegisterPaytableReader()
+{
+	std::lock_guard<std::mutex> lock(g_paytableLock);
+	PaytableReader* reader = nullptr;
+	for (PaytableReader* unused : g_paytableReaders)
+	{
+		if (!unused->InUse)
+		{
+			reader = unused;
+			break;
+		}
+	}
+	if (reader == nullptr)
+	{
+		reader = new PaytableReader;
+		g_paytableReaders.push_back(reader);
+	}
+
+	reader->InUse = true;
+	reader->SeenPublishCount.store(g_paytablePublishCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	return reader;
+}
+
+//frees every retired version that no reader could still be holding.  Call while holding g_paytableLock.
+static void FreeRetiredPaytables()
+{
+	uint64_t oldestSeen = UINT64_MAX;
+	for (PaytableReader* reader : g_paytableReaders)
+	{
+		if (reader->InUse)
+		{
+			uint64_t seen = reader->SeenPublishCount.load(std::memory_order_acquire);
+			oldestSeen = seen < oldestSeen ? seen : oldestSeen;
+		}
+	}
+
+	size_t kept = 0;
+	for (size_t i = 0; i < g_retiredPaytables.size(); ++i)
+	{
+		if (g_retiredPaytables[i].RetiredAtPublishCount <= oldestSeen)
+		{
+			delete g_retiredPaytables[i].Paytable;
+			g_paytablesFreed++;
+		}
+		else
+		{
+			g_retiredPaytables[kept++] = g_retiredPaytables[i];
+		}
+	}
+	g_retiredPaytables.resize(kept);
+	return;
+}
+
+//hands the reader slot back when its thread exits, so the thread is never waited on again
+struct PaytableReaderHandle
+{
+	PaytableReader* Reader = nullptr;
+
+	~PaytableReaderHandle()
+	{
+		if (Reader != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(g_paytableLock);
+			Reader->InUse = false;
+			FreeRetiredPaytables();
+		}
+	}
+};
+
+static thread_local PaytableReaderHandle t_paytableReader;
+
+//gives the paytable a spin should be played on.  It stays valid until the same thread calls this again,
+//so take it once at the start of a spin and use the same one all the way through to paying out.
+const PublishedPaytable& BeginPaytableRead()
+{
+	PaytableReader* reader = t_paytableReader.Reader;
+	if (reader == nullptr)
+	{
+		reader = RegisterPaytableReader();
+		t_paytableReader.Reader = reader;
+	}
+
+	//anything from the last spin is finished with.  If this sees a publish, the pointer load below sees the new version.
+	reader->SeenPublishCount.store(g_paytablePublishCount.load(std::memory_order_acquire), std::memory_order_release);
+	return *g_pCurrentPaytable.load(std::memory_order_acquire);
+}
+
+//swaps in a new paytable for every spin that starts from now on.  Spins already under way finish on the old one.
+//returns the new version number, or 0 if the paytable isn't valid
+uint64_t PublishPaytable(const SlotPaytable& _paytable)
+{
+	if (!IsValidPaytable(_paytable))
+	{
+		return 0;
+	}
+
+	PublishedPaytable* published = new PublishedPaytable;
+	published->Paytable = _paytable;
+	published->Stats = EvaluatePaytable(_paytable);
+
+	std::lock_guard<std::mutex> lock(g_paytableLock);
+	published->Version = ++g_lastPaytableVersion;
+	const PublishedPaytable* replaced = g_pCurrentPaytable.exchange(published, std::memory_order_acq_rel);
+	uint64_t publishCount = g_paytablePublishCount.load(std::memory_order_relaxed) + 1;
+	g_paytablePublishCount.store(publishCount, std::memory_order_release);
+
+	if (replaced != &g_builtInPaytable)
+	{
+		RetiredPaytable retired = { replaced, publishCount };
+		g_retiredPaytables.push_back(retired);
+	}
+	FreeRetiredPaytables();
+	return published->Version;
+}
+
+//how many replaced paytables are still waiting for a reader to move on
+long long GetRetiredPaytableCount()
+{
+	std::lock_guard<std::mutex> lock(g_paytableLock);
+	FreeRetiredPaytables();
+	return (long long)g_retiredPaytables.size();
+}
+
+//checks a paytable can be played: no negative payouts or weights, and at least one value that can land
+bool IsValidPaytable(const SlotPaytable& _paytable)
+{
+	const int maxValue = 1000000; //keeps the total weight well inside an int.  Bets times multipliers can still pass an int,
+	                              //so bets that could win more than the player can hold are turned away by CanPayBet.
+	if (_paytable.TwoMatchMultiplier < 0 || _paytable.ThreeMatchMultiplier < 0 || _paytable.JackpotMultiplier < 0
+		|| _paytable.TwoMatchMultiplier > maxValue || _paytable.ThreeMatchMultiplier > maxValue || _paytable.JackpotMultiplier > maxValue)
+	{
+		return false;
+	}
+
+	int totalWeight = 0;
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		if (_paytable.ReelWeights[i] < 0 || _paytable.ReelWeights[i] > maxValue)
+		{
+			return false;
+		}
+		totalWeight += _paytable.ReelWeights[i];
+	}
+	return totalWeight > 0;
+}
+
+//reads a paytable written as "name=value" settings, split by spaces or new lines, with # starting a comment:
+//  two=3 three=5 jackpot=10 weights=1 1 1 1 1 1
+//the same form the optimiser prints after the "|", so one of its results can be pasted straight in.
+//anything not given keeps the built in value.  Returns false if anything can't be read, or the paytable isn't valid.
+bool ParsePaytable(const std::string& _strText, SlotPaytable* _pPaytable)
+{
+	SlotPaytable paytable;
+	std::istringstream lines(_strText);
+	std::string line;
+	int weightsRead = -1; //-1 until weights= is seen
+	while (std::getline(lines, line))
+	{
+		std::istringstream words(line.substr(0, line.find('#')));
+		std::string word;
+		while (words >> word)
+		{
+			size_t equals = word.find('=');
+			std::string name = equals == std::string::npos ? "" : word.substr(0, equals);
+			std::string value = equals == std::string::npos ? word : word.substr(equals + 1);
+			if (name == "weights")
+			{
+				weightsRead = 0;
+				if (value.empty()) //"weights= 1 2 3 ..."
+				{
+					continue;
+				}
+			}
+
+			char* numberEnd = nullptr;
+			long number = std::strtol(value.c_str(), &numberEnd, 10);
+			if (value.empty() || *numberEnd != '\0')
+			{
+				return false;
+			}
+
+			if (name == "two")
+			{
+				paytable.TwoMatchMultiplier = (int)number;
+			}
+			else if (name == "three")
+			{
+				paytable.ThreeMatchMultiplier = (int)number;
+			}
+			else if (name == "jackpot")
+			{
+				paytable.JackpotMultiplier = (int)number;
+			}
+			else if ((name == "weights" || name.empty()) && weightsRead >= 0 && weightsRead < REEL_SYMBOL_COUNT)
+			{
+				paytable.ReelWeights[weightsRead++] = (int)number;
+			}
+			else
+			{
+				return false;
+			}
+		}
+	}
+
+	if ((weightsRead >= 0 && weightsRead != REEL_SYMBOL_COUNT) || !IsValidPaytable(paytable))
+	{
+		return false;
+	}
+	*_pPaytable = paytable;
+	return true;
+}
+
+//reads a paytable from a file.  Returns false if the file can't be opened or read.
+bool LoadPaytableFile(const std::string& _strFileName, SlotPaytable* _pPaytable)
+{
+	std::ifstream file(_strFileName);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+	return ParsePaytable(text.str(), _pPaytable);
+}
+
+//background thread that publishes the paytable file whenever it changes
+struct PaytableWatcher
+{
+	std::thread Thread;
+	std::mutex StopMutex;
+	std::condition_variable StopSignal;
+	bool IsStopping = false;
+	std::string FileName;
+	double IntervalSeconds = PAYTABLE_WATCH_INTERVAL_SECONDS;
+	std::string LastText; //what the file held last time it was read
+};
+
+static PaytableWatcher* g_pPaytableWatcher = nullptr;
+
+//reads the file and publishes it if it has changed since last time.  A file that is missing or can't be read is
+//ignored, so a half saved file or a typo leaves the last good paytable in play.
+static void CheckPaytableFile(PaytableWatcher* _pWatcher)
+{
+	std::ifstream file(_pWatcher->FileName);
+	if (!file.is_open())
+	{
+		return;
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+	if (text.str() == _pWatcher->LastText)
+	{
+		return;
+	}
+	_pWatcher->LastText = text.str();
+
+	SlotPaytable paytable;
+	if (ParsePaytable(_pWatcher->LastText, &paytable))
+	{
+		PublishPaytable(paytable);
+	}
+	return;
+}
+
+//checks the file every interval until told to stop, freeing old paytables as readers move on
+static void RunPaytableWatcher(PaytableWatcher* _pWatcher)
+{
+	std::unique_lock<std::mutex> lock(_pWatcher->StopMutex);
+	while (!_pWatcher->IsStopping)
+	{
+		_pWatcher->StopSignal.wait_for(lock, std::chrono::microseconds((long long)(_pWatcher->IntervalSeconds * 1e6)));
+		if (!_pWatcher->IsStopping)
+		{
+			CheckPaytableFile(_pWatcher);
+			GetRetiredPaytableCount();
+		}
+	}
+	return;
+}
+
+//publishes the paytable file now if there is one, then keeps watching it for changes.
+//returns false if the file is there but couldn't be used, in which case the built in paytable stays in play.
+bool StartPaytableWatcher(const std::string& _strFileName, double _dIntervalSeconds)
+{
+	if (g_pPaytableWatcher != nullptr)
+	{
+		return true;
+	}
+
+	g_pPaytableWatcher = new PaytableWatcher;
+	g_pPaytableWatcher->FileName = _strFileName;
+	g_pPaytableWatcher->IntervalSeconds = _dIntervalSeconds > 0.0 ? _dIntervalSeconds : PAYTABLE_WATCH_INTERVAL_SECONDS;
+
+	uint64_t versionBefore = BeginPaytableRead().Version;
+	CheckPaytableFile(g_pPaytableWatcher);
+	bool fileUsable = g_pPaytableWatcher->LastText.empty() || BeginPaytableRead().Version != versionBefore;
+
+	g_pPaytableWatcher->Thread = std::thread(RunPaytableWatcher, g_pPaytableWatcher);
+
+	CleanUpAtExit(StopPaytableWatcher);
+	return fileUsable;
+}
+
+//stops watching the paytable file.  The paytable in play stays as it is.
+void StopPaytableWatcher()
+{
+	if (g_pPaytableWatcher == nullptr)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(g_pPaytableWatcher->StopMutex);
+		g_pPaytableWatcher->IsStopping = true;
+	}
+	g_pPaytableWatcher->StopSignal.notify_all();
+	g_pPaytableWatcher->Thread.join();
+	delete g_pPaytableWatcher;
+	g_pPaytableWatcher = nullptr;
+	return;
+}
+
+//a paytable whose every setting is worked out from its version number, so a reader can tell if it saw a mix of two
+static SlotPaytable GetStressPaytable(uint64_t _iVersion)
+{
+	SlotPaytable paytable;
+	paytable.TwoMatchMultiplier = (int)(_iVersion % 1000);
+	paytable.ThreeMatchMultiplier = paytable.TwoMatchMultiplier + 1;
+	paytable.JackpotMultiplier = paytable.TwoMatchMultiplier + 2;
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		paytable.ReelWeights[i] = paytable.TwoMatchMultiplier + 3 + i;
+	}
+	return paytable;
+}
+
+//has every thread spin on the live paytable while one thread publishes new ones as fast as it can,
+//checking each spin saw one whole version and that every replaced version was freed by the end.
+//the built in paytable is put back afterwards.
+PaytableStressReport RunPaytableStressTest(int _iThreadCount, double _dSeconds)
+{
+	PaytableStressReport report;
+
+	_iThreadCount = GetWorkerThreadCount(_iThreadCount);
+
+	long long freedBefore = 0;
+	{
+		std::lock_guard<std::mutex> lock(g_paytableLock);
+		freedBefore = g_paytablesFreed;
+	}
+
+	uint64_t firstVersion = PublishPaytable(GetStressPaytable(BeginPaytableRead().Version + 1));
+	std::atomic<bool> keepSpinning(true);
+	std::vector<long long> spinsChecked(_iThreadCount, 0);
+	std::vector<char> sawTornRead(_iThreadCount, 0);
+
+	auto spinWorker = [&](int _iThreadIndex)
+	{
+		long long spins = 0;
+		bool torn = false;
+		while (keepSpinning.load(std::memory_order_relaxed))
+		{
+			const PublishedPaytable& published = BeginPaytableRead();
+			const SlotPaytable& paytable = published.Paytable;
+			int base = paytable.TwoMatchMultiplier;
+			if (published.Version >= firstVersion)
+			{
+				//read it slowly, as a real spin would, to give a swap the chance to land part way through
+				for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+				{
+					std::this_thread::yield();
+					torn = torn || paytable.ReelWeights[i] != base + 3 + i;
+				}
+				torn = torn || paytable.ThreeMatchMultiplier != base + 1 || paytable.JackpotMultiplier != base + 2
+					|| base != (int)(published.Version % 1000);
+			}
+			spins++;
+		}
+		spinsChecked[_iThreadIndex] = spins;
+		sawTornRead[_iThreadIndex] = torn ? 1 : 0;
+	};
+
+	auto startTime = std::chrono::steady_clock::now();
+	auto endTime = startTime + std::chrono::microseconds((long long)(_dSeconds * 1e6));
+	std::vector<std::thread> workers;
+	for (int i = 0; i < _iThreadCount; ++i)
+	{
+		workers.push_back(std::thread(spinWorker, i));
+	}
+	uint64_t version = firstVersion;
+	report.PaytablesPublished++;
+	while (std::chrono::steady_clock::now() < endTime)
+	{
+		version = PublishPaytable(GetStressPaytable(version + 1));
+		report.PaytablesPublished++;
+	}
+	keepSpinning.store(false, std::memory_order_relaxed);
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	PublishPaytable(SlotPaytable());
+	report.PaytablesPublished++;
+	report.SecondsTaken = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	report.NoTornReads = true;
+	for (int i = 0; i < _iThreadCount; ++i)
+	{
+		report.SpinsChecked += spinsChecked[i];
+		report.NoTornReads = report.NoTornReads && sawTornRead[i] == 0;
+	}
+
+	//the spinning threads have exited and handed back their slots, so only this thread's own last read can hold anything
+	BeginPaytableRead();
+	long long stillRetired = GetRetiredPaytableCount();
+	{
+		std::lock_guard<std::mutex> lock(g_paytableLock);
+		report.PaytablesFreed = g_paytablesFreed - freedBefore;
+	}
+	report.AllFreed = stillRetired == 0;
+	return report;
+}
@@ -0,0 +1,51 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : LivePaytable.h
+Description : The paytable spins are played on, which can be swapped for a new one while sessions are spinning
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "SlotEngine.h"
+
+const double PAYTABLE_WATCH_INTERVAL_SECONDS = 1.0; //how often the paytable file is checked for changes
+
+//one version of the paytable.  Never changed once published - a change publishes a whole new version instead.
+struct PublishedPaytable
+{
+	SlotPaytable Paytable;
+	uint64_t Version = 1; //the built in paytable is version 1, every paytable published after it counts up from there
+	PaytableStats Stats;
+};
+
+//results of swapping paytables as fast as possible while other threads spin on them
+struct PaytableStressReport
+{
+	long long SpinsChecked = 0;
+	long long PaytablesPublished = 0;
+	long long PaytablesFreed = 0;
+	double SecondsTaken = 0.0;
+	bool NoTornReads = false; //every spin saw one whole version of the paytable, never a mix of two
+	bool AllFreed = false; //every replaced paytable was freed once nothing could still be using it
+};
+
+const PublishedPaytable& BeginPaytableRead();
+uint64_t PublishPaytable(const SlotPaytable& _paytable);
+long long GetRetiredPaytableCount();
+
+bool IsValidPaytable(const SlotPaytable& _paytable);
+bool ParsePaytable(const std::string& _strText, SlotPaytable* _pPaytable);
+bool LoadPaytableFile(const std::string& _strFileName, SlotPaytable* _pPaytable);
+bool StartPaytableWatcher(const std::string& _strFileName, double _dIntervalSeconds = PAYTABLE_WATCH_INTERVAL_SECONDS);
+void StopPaytableWatcher();
+
+PaytableStressReport RunPaytableStressTest(int _iThreadCount, double _dSeconds);
@@ -0,0 +1,541 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : LoadGenerator.cpp
+Description : Drives thousands of virtual players through headless sessions and measures how the machine copes
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <windows.h>
+#include <mmsystem.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "LoadGenerator.h"
+#include "SlotSession.h"
+#include "SessionSnapshot.h"
+#include "ProgressiveJackpot.h"
+#include "SystemHelpers.h"
+
+#pragma comment(lib, "winmm.lib")
+
+const int HISTOGRAM_SUB_BUCKETS = 16; //linear steps inside each power of 2, so percentiles are within about 6%
+const int HISTOGRAM_BUCKETS = 64 * HISTOGRAM_SUB_BUCKETS;
+
+//counts latencies (in nanoseconds) into power of 2 buckets, each split into equal steps.
+//one per thread, added together at the end, so recording a latency is just an increment.
+struct LatencyHistogram
+{
+	long long Counts[HISTOGRAM_BUCKETS] = {};
+	long long Total = 0;
+	long long Max = 0;
+
+	static int GetBucket(long long _iNanoseconds)
+	{
+		uint64_t value = _iNanoseconds > 0 ? (uint64_t)_iNanoseconds : 0;
+		if (value < HISTOGRAM_SUB_BUCKETS)
+		{
+			return (int)value;
+		}
+
+		int highestBit = 63;
+		while ((value >> highestBit) == 0)
+		{
+			highestBit--;
+		}
+		int step = (int)((value >> (highestBit - 4)) & (HISTOGRAM_SUB_BUCKETS - 1));
+		return (highestBit - 3) * HISTOGRAM_SUB_BUCKETS + step;
+	}
+
+	//smallest latency that lands in a bucket
+	static long long GetBucketValue(int _iBucket)
+	{
+		if (_iBucket < HISTOGRAM_SUB_BUCKETS)
+		{
+			return _iBucket;
+		}
+		int highestBit = _iBucket / HISTOGRAM_SUB_BUCKETS + 3;
+		int step = _iBucket % HISTOGRAM_SUB_BUCKETS;
+		return ((long long)HISTOGRAM_SUB_BUCKETS + step) << (highestBit - 4);
+	}
+
+	void Add(long long _iNanoseconds)
+	{
+		Counts[GetBucket(_iNanoseconds)]++;
+		Total++;
+		if (_iNanoseconds > Max)
+		{
+			Max = _iNanoseconds;
+		}
+	}
+
+	void Merge(const LatencyHistogram& _other)
+	{
+		for (int i = 0; i < HISTOGRAM_BUCKETS; ++i)
+		{
+			Counts[i] += _other.Counts[i];
+		}
+		Total += _other.Total;
+		if (_other.Max > Max)
+		{
+			Max = _other.Max;
+		}
+	}
+
+	//latency that the given fraction of actions were at or under
+	long long GetPercentile(double _dFraction) const
+	{
+		long long target = (long long)(_dFraction * Total);
+		long long seen = 0;
+		for (int i = 0; i < HISTOGRAM_BUCKETS; ++i)
+		{
+			seen += Counts[i];
+			if (seen > target)
+			{
+				return GetBucketValue(i);
+			}
+		}
+		return Max;
+	}
+};
+
+//everything one worker thread counts, merged into the report at the end
+struct LoadWorkerResults
+{
+	LatencyHistogram Latency;
+	long long Actions = 0;
+	long long Spins = 0;
+	long long InputErrors = 0;
+	long long SessionsQuit = 0;
+	long long SessionsOutOfChips = 0;
+	long long SessionsExpelled = 0;
+};
+
+//quick xorshift for virtual player decisions - they only need to look varied, not be secure
+static uint32_t NextPlayerRandom(uint32_t& _iState)
+{
+	_iState ^= _iState << 13;
+	_iState ^= _iState >> 17;
+	_iState ^= _iState << 5;
+	return _iState;
+}
+
+//random whole number from min to max for a virtual player
+static int GetPlayerRandom(uint32_t& _iState, int _iMin, int _iMax)
+{
+	if (_iMax <= _iMin)
+	{
+		return _iMin;
+	}
+	return _iMin + (int)(NextPlayerRandom(_iState) % (uint32_t)(_iMax - _iMin + 1));
+}
+
+//something a player might type by mistake, covering every kind of input error
+static string GetInvalidInput(uint32_t& _iState)
+{
+	switch (NextPlayerRandom(_iState) % 4)
+	{
+	case 0:
+		return "";
+	case 1:
+		return "abc";
+	case 2:
+		return "-5";
+	default:
+		return "9.5";
+	}
+}
+
+//decides what a virtual player types next, based on which question the session is asking
+static string ChooseVirtualPlayerInput(SlotSession& session, uint32_t& state, const VirtualPlayerMix& _mix)
+{
+	int chips = session.User.GetChips();
+
+	if (session.State == ESessionState::AWAITING_ACKNOWLEDGEMENT || session.State == ESessionState::AUTO_PLAYING)
+	{
+		return ""; //any key will do
+	}
+	if (GetPlayerRandom(state, 1, 100) <= _mix.InvalidPercent)
+	{
+		return GetInvalidInput(state);
+	}
+
+	switch (session.State)
+	{
+	case ESessionState::AT_MENU:
+	{
+		int totalWeight = _mix.PlayWeight + _mix.CreditsWeight + _mix.WinningsWeight + _mix.CashOutWeight + _mix.BuyChipsWeight + _mix.QuitWeight
+			+ _mix.AutoPlayWeight;
+		int pick = GetPlayerRandom(state, 1, totalWeight > 0 ? totalWeight : 1);
+		if ((pick -= _mix.PlayWeight) <= 0)
+		{
+			return "1";
+		}
+		if ((pick -= _mix.CreditsWeight) <= 0)
+		{
+			return "2";
+		}
+		if ((pick -= _mix.WinningsWeight) <= 0)
+		{
+			return "4";
+		}
+		if ((pick -= _mix.CashOutWeight) <= 0)
+		{
+			return "5";
+		}
+		if ((pick -= _mix.BuyChipsWeight) <= 0)
+		{
+			return "6"; //not on the menu above 500 chips, which exercises that error too
+		}
+		if ((pick -= _mix.AutoPlayWeight) <= 0)
+		{
+			return "7";
+		}
+		return "3";
+	}
+	case ESessionState::AWAITING_BET:
+		if (GetPlayerRandom(state, 1, 20) == 1) //occasionally bet more than they have
+		{
+			return std::to_string(chips + GetPlayerRandom(state, 1, 1000));
+		}
+		return std::to_string(GetPlayerRandom(state, 1, chips > 10 ? chips / 10 : 1));
+	case ESessionState::AWAITING_PURCHASE:
+	case ESessionState::AWAITING_TOP_UP_PURCHASE:
+		return std::to_string(GetPlayerRandom(state, 0, 6000));
+	case ESessionState::AWAITING_CASH_OUT:
+		return std::to_string(GetPlayerRandom(state, 0, chips));
+	case ESessionState::AWAITING_TOP_UP_CHOICE:
+		return GetPlayerRandom(state, 1, 4) == 1 ? "0" : "1";
+	case ESessionState::AWAITING_AUTO_SPIN_COUNT:
+		return std::to_string(GetPlayerRandom(state, 0, 200));
+	case ESessionState::AWAITING_AUTO_BET:
+		return std::to_string(GetPlayerRandom(state, 1, chips > 10 ? chips / 10 : 1));
+	case ESessionState::AWAITING_AUTO_BALANCE_FLOOR:
+		return GetPlayerRandom(state, 1, 2) == 1 ? "0" : std::to_string(GetPlayerRandom(state, 0, chips / 2));
+	case ESessionState::AWAITING_AUTO_WIN_LIMIT:
+		return GetPlayerRandom(state, 1, 2) == 1 ? "0" : std::to_string(GetPlayerRandom(state, 100, 10000));
+	case ESessionState::AWAITING_AUTO_JACKPOT_CHOICE:
+		return GetPlayerRandom(state, 1, 2) == 1 ? "0" : "1";
+	default:
+		return "";
+	}
+}
+
+//runs a share of the virtual players (from _iFirstPlayer up to but not including _iEndPlayer) on one thread until the time is up.
+//players wait in a queue ordered by when their think time finishes, so thousands can share a thread.
+static void RunLoadWorker(const LoadTestOptions* _pOptions, SlotSession* _pSessions, uint32_t* _pRandomStates, size_t _iFirstPlayer, size_t _iEndPlayer,
+	int _iWorker, SessionSnapshotter* _pSnapshotter, LoadWorkerResults* _pResults, std::chrono::steady_clock::time_point _endTime)
+{
+	typedef std::chrono::steady_clock Clock;
+	typedef std::pair<long long, size_t> ScheduledAction; //when it is due (nanoseconds since start), which player
+
+	if (_pSnapshotter != nullptr)
+	{
+		_pSnapshotter->StartWorker(_iWorker);
+	}
+
+	const bool hasThinkTime = _pOptions->ThinkTimeMaxMs > 0;
+	Clock::time_point startTime = Clock::now();
+	std::priority_queue<ScheduledAction, std::vector<ScheduledAction>, std::greater<ScheduledAction>> dueActions;
+	for (size_t i = _iFirstPlayer; i < _iEndPlayer; ++i)
+	{
+		long long firstAction = hasThinkTime ? GetPlayerRandom(_pRandomStates[i], 0, _pOptions->ThinkTimeMaxMs) * 1000000LL : 0;
+		dueActions.push(ScheduledAction(firstAction, i));
+	}
+
+	while (!dueActions.empty())
+	{
+		if (_pSnapshotter != nullptr)
+		{
+			_pSnapshotter->CheckIn(_iWorker); //between actions is the only safe time to hand sessions over for a snapshot
+		}
+
+		Clock::time_point now = Clock::now();
+		if (now >= _endTime)
+		{
+			break;
+		}
+
+		ScheduledAction next = dueActions.top();
+		long long nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now - startTime).count();
+		if (next.first > nowNs)
+		{
+			if (next.first - nowNs > 2000000) //more than 2ms to wait, give the core back
+			{
+				Sleep(1); //about 1ms, as RunLoadTest turns the timer resolution up for the run
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+			continue;
+		}
+		dueActions.pop();
+
+		SlotSession& session = _pSessions[next.second];
+		uint32_t& randomState = _pRandomStates[next.second];
+		long long spinsBefore = session.SpinCount;
+		int errorsBefore = session.User.GetErrors();
+		//while auto play runs, each action is the next spin - unless the player gets bored and presses a key
+		bool autoSpin = session.State == ESessionState::AUTO_PLAYING && GetPlayerRandom(randomState, 1, 50) != 1;
+		string input = autoSpin ? "" : ChooseVirtualPlayerInput(session, randomState, _pOptions->Mix);
+
+		Clock::time_point actionStart = Clock::now();
+		if (autoSpin)
+		{
+			PlaySessionAutoSpin(&session);
+		}
+		else
+		{
+			HandleSessionInput(&session, input);
+		}
+		Clock::time_point actionEnd = Clock::now();
+		long long actionEndNs = std::chrono::duration_cast<std::chrono::nanoseconds>(actionEnd - startTime).count();
+
+		//with think time, measure from when the action was due so time spent queued behind other players counts too.
+		//without it every player is always due, so only the action itself is timed.
+		_pResults->Latency.Add(hasThinkTime ? actionEndNs - next.first : std::chrono::duration_cast<std::chrono::nanoseconds>(actionEnd - actionStart).count());
+		_pResults->Actions++;
+		if (session.User.GetErrors() > errorsBefore)
+		{
+			_pResults->InputErrors++;
+		}
+		_pResults->Spins += session.SpinCount - spinsBefore;
+
+		if (session.State == ESessionState::ENDED)
+		{
+			switch (session.ExitCode)
+			{
+			case EExitCode::OUT_OF_CHIPS:
+				_pResults->SessionsOutOfChips++;
+				break;
+			case EExitCode::TOO_MANY_BAD_INPUTS:
+				_pResults->SessionsExpelled++;
+				break;
+			default:
+				_pResults->SessionsQuit++;
+				break;
+			}
+			StartSession(&session); //a new player takes the seat straight away, so the load stays the same
+		}
+		if (_pSnapshotter != nullptr)
+		{
+			_pSnapshotter->MarkDirty(_iWorker, next.second);
+		}
+
+		long long thinkNs = hasThinkTime ? GetPlayerRandom(randomState, _pOptions->ThinkTimeMinMs, _pOptions->ThinkTimeMaxMs) * 1000000LL : 0;
+		dueActions.push(ScheduledAction(actionEndNs + thinkNs, next.second));
+	}
+
+	if (_pSnapshotter != nullptr)
+	{
+		_pSnapshotter->FinishWorker(_iWorker);
+	}
+	return;
+}
+
+//brings every session in a snapshot back, along with the jackpot pool.  Returns false if the file can't be used.
+static bool RestoreLoadTestSessions(const std::string& _strFileName, std::vector<SlotSession>* _pSessions)
+{
+	SessionSnapshotReader reader;
+	if (!reader.Open(_strFileName))
+	{
+		return false;
+	}
+
+	const SessionRecord* records = reader.GetRecords();
+	size_t count = (size_t)reader.GetSessionCount();
+	_pSessions->resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		RestoreSessionRecord(records[i], &(*_pSessions)[i]);
+	}
+
+	const SessionSnapshotHeader* header = reader.GetHeader();
+	GetProgressiveJackpot().RestorePool(header->JackpotHundredths, header->JackpotPoolsClaimed);
+	return true;
+}
+
+//fills in one of the built in behaviour mixes.  Returns false if the name isn't recognised.
+bool GetVirtualPlayerMix(const std::string& _strName, VirtualPlayerMix* _pMix)
+{
+	VirtualPlayerMix mix; //defaults are "casual" - browses the menus, plays a fair bit, rarely makes mistakes
+	if (_strName == "grinder") //just wants to spin
+	{
+		mix.PlayWeight = 90;
+		mix.CreditsWeight = 0;
+		mix.WinningsWeight = 2;
+		mix.CashOutWeight = 1;
+		mix.BuyChipsWeight = 6;
+		mix.QuitWeight = 1;
+		mix.AutoPlayWeight = 10;
+		mix.InvalidPercent = 1;
+	}
+	else if (_strName == "troublemaker") //keeps typing rubbish until security steps in
+	{
+		mix.PlayWeight = 40;
+		mix.InvalidPercent = 30;
+	}
+	else if (_strName != "casual")
+	{
+		return false;
+	}
+
+	*_pMix = mix;
+	return true;
+}
+
+//sits the virtual players down, runs them across every core for the set time, and gathers up the results
+LoadTestReport RunLoadTest(const LoadTestOptions& _options)
+{
+	LoadTestReport report;
+
+	int threadCount = GetWorkerThreadCount(_options.ThreadCount);
+	report.ThreadsUsed = threadCount;
+
+	//sit the players down, either fresh or exactly where a snapshot left them
+	std::vector<SlotSession> sessions;
+	if (!_options.RestoreFile.empty())
+	{
+		auto restoreStart = std::chrono::steady_clock::now();
+		if (!RestoreLoadTestSessions(_options.RestoreFile, &sessions))
+		{
+			report.RestoreFailed = true;
+			return report;
+		}
+		report.RestoreSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - restoreStart).count();
+		report.RestoredSessions = (long long)sessions.size();
+	}
+	else
+	{
+		sessions.resize(_options.PlayerCount > 0 ? (size_t)_options.PlayerCount : 0);
+		for (SlotSession& session : sessions)
+		{
+			StartSession(&session);
+		}
+	}
+	report.PlayerCount = (long long)sessions.size();
+
+	std::vector<uint32_t> randomStates(sessions.size());
+	for (size_t i = 0; i < randomStates.size(); ++i)
+	{
+		randomStates[i] = 2463534242u ^ ((uint32_t)i * 2654435761u);
+		if (randomStates[i] == 0)
+		{
+			randomStates[i] = 1;
+		}
+	}
+
+	SessionSnapshotter snapshotter;
+	SessionSnapshotter* pSnapshotter = nullptr;
+	if (!_options.SnapshotFile.empty())
+	{
+		if (!snapshotter.Start(_options.SnapshotFile, sessions.data(), sessions.size(), threadCount, _options.SnapshotIntervalSeconds))
+		{
+			report.SnapshotsFailed = true;
+			return report;
+		}
+		pSnapshotter = &snapshotter;
+	}
+
+	//Sleep(1) normally sleeps for a whole timer tick (about 15.6ms), which would swamp the latencies measured from
+	//each action's due time.  Asking for a 1ms timer while the players think keeps the wait close to what was asked for.
+	const bool hasThinkTime = _options.ThinkTimeMaxMs > 0;
+	if (hasThinkTime)
+	{
+		timeBeginPeriod(1);
+	}
+
+	//deal the players out between the threads in blocks, each thread only ever touches its own players
+	std::vector<LoadWorkerResults> threadResults(threadCount);
+	std::vector<std::thread> workers;
+	auto startTime = std::chrono::steady_clock::now();
+	auto endTime = startTime + std::chrono::microseconds((long long)(_options.DurationSeconds * 1e6));
+	for (int i = 0; i < threadCount; ++i)
+	{
+		size_t firstPlayer = sessions.size() * i / threadCount;
+		size_t endPlayer = sessions.size() * (i + 1) / threadCount;
+		workers.push_back(std::thread(RunLoadWorker, &_options, sessions.data(), randomStates.data(), firstPlayer, endPlayer,
+			i, pSnapshotter, &threadResults[i], endTime));
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	report.SecondsTaken = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	if (hasThinkTime)
+	{
+		timeEndPeriod(1);
+	}
+
+	LatencyHistogram latency;
+	for (const LoadWorkerResults& results : threadResults)
+	{
+		latency.Merge(results.Latency);
+		report.Actions += results.Actions;
+		report.Spins += results.Spins;
+		report.InputErrors += results.InputErrors;
+		report.SessionsQuit += results.SessionsQuit;
+		report.SessionsOutOfChips += results.SessionsOutOfChips;
+		report.SessionsExpelled += results.SessionsExpelled;
+	}
+
+	report.ActionsPerSecond = report.Actions / report.SecondsTaken;
+	report.LatencyP50 = latency.GetPercentile(0.50) / 1000.0;
+	report.LatencyP99 = latency.GetPercentile(0.99) / 1000.0;
+	report.LatencyP999 = latency.GetPercentile(0.999) / 1000.0;
+	report.LatencyMax = latency.Max / 1000.0;
+
+	if (pSnapshotter != nullptr)
+	{
+		SessionSnapshotStats snapshotStats = snapshotter.Stop();
+		report.SnapshotsWritten = snapshotStats.SnapshotsWritten;
+		report.SnapshotWriteSeconds = snapshotStats.LastWriteSeconds;
+		report.SnapshotLongestPause = snapshotStats.LongestPauseMicroseconds;
+		report.SnapshotsFailed = !snapshotStats.AllWritten;
+	}
+	return report;
+}
+
+//writes the report as one "name=value" per line, so reports from different builds can be compared with a diff tool
+std::string FormatLoadTestReport(const LoadTestOptions& _options, const LoadTestReport& _report)
+{
+	std::ostringstream text;
+	text << "players=" << _report.PlayerCount << "\n";
+	text << "threads=" << _report.ThreadsUsed << "\n";
+	text << "mix=" << _options.MixName << "\n";
+	text << "think_ms=" << _options.ThinkTimeMinMs << "-" << _options.ThinkTimeMaxMs << "\n";
+	text << "seconds=" << _report.SecondsTaken << "\n";
+	text << "actions=" << _report.Actions << "\n";
+	text << "actions_per_second=" << (long long)_report.ActionsPerSecond << "\n";
+	text << "latency_p50_us=" << _report.LatencyP50 << "\n";
+	text << "latency_p99_us=" << _report.LatencyP99 << "\n";
+	text << "latency_p999_us=" << _report.LatencyP999 << "\n";
+	text << "latency_max_us=" << _report.LatencyMax << "\n";
+	text << "spins=" << _report.Spins << "\n";
+	text << "input_errors=" << _report.InputErrors << "\n";
+	text << "sessions_quit=" << _report.SessionsQuit << "\n";
+	text << "sessions_out_of_chips=" << _report.SessionsOutOfChips << "\n";
+	text << "sessions_expelled=" << _report.SessionsExpelled << "\n";
+	if (!_options.RestoreFile.empty())
+	{
+		text << "restored_sessions=" << _report.RestoredSessions << "\n";
+		text << "restore_ms=" << _report.RestoreSeconds * 1000.0 << "\n";
+	}
+	if (!_options.SnapshotFile.empty())
+	{
+		text << "snapshots=" << _report.SnapshotsWritten << "\n";
+		text << "snapshot_write_ms=" << _report.SnapshotWriteSeconds * 1000.0 << "\n";
+		text << "snapshot_longest_pause_us=" << _report.SnapshotLongestPause << "\n";
+	}
+	return text.str();
+}
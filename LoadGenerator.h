@@ -0,0 +1,74 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : LoadGenerator.h
+Description : Drives thousands of virtual players through headless sessions and measures how the machine copes
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <string>
+
+//how likely a virtual player is to pick each option at the main menu (relative weights, they don't need to add to 100),
+//plus the percentage chance of typing something invalid at any prompt
+struct VirtualPlayerMix
+{
+	int PlayWeight = 60;
+	int CreditsWeight = 3;
+	int WinningsWeight = 10;
+	int CashOutWeight = 5;
+	int BuyChipsWeight = 10;
+	int QuitWeight = 2;
+	int AutoPlayWeight = 3;
+	int InvalidPercent = 5;
+};
+
+//settings for a load test run
+struct LoadTestOptions
+{
+	int PlayerCount = 20000;
+	int ThreadCount = 0; //0 uses every core
+	double DurationSeconds = 10.0;
+	int ThinkTimeMinMs = 0; //pause between a player's actions, picked evenly between min and max
+	int ThinkTimeMaxMs = 0;
+	std::string MixName = "casual";
+	VirtualPlayerMix Mix;
+	std::string SnapshotFile; //if set, every session is snapshotted to this file while the test runs
+	double SnapshotIntervalSeconds = 1.0;
+	std::string RestoreFile; //if set, the players pick up where this snapshot left them instead of starting fresh
+};
+
+//what happened during a load test.  Latencies are in microseconds.
+struct LoadTestReport
+{
+	long long PlayerCount = 0;
+	long long Actions = 0;
+	long long Spins = 0;
+	long long InputErrors = 0;
+	long long SessionsQuit = 0;
+	long long SessionsOutOfChips = 0;
+	long long SessionsExpelled = 0;
+	double SecondsTaken = 0.0;
+	double ActionsPerSecond = 0.0;
+	double LatencyP50 = 0.0;
+	double LatencyP99 = 0.0;
+	double LatencyP999 = 0.0;
+	double LatencyMax = 0.0;
+	int ThreadsUsed = 0;
+	long long RestoredSessions = 0;
+	double RestoreSeconds = 0.0;
+	bool RestoreFailed = false; //the restore file was missing or damaged, so the test didn't run
+	long long SnapshotsWritten = 0;
+	double SnapshotWriteSeconds = 0.0; //time taken to write the last snapshot
+	double SnapshotLongestPause = 0.0; //longest any worker stopped to hand its sessions over for a snapshot
+	bool SnapshotsFailed = false;
+};
+
+bool GetVirtualPlayerMix(const std::string& _strName, VirtualPlayerMix* _pMix);
+LoadTestReport RunLoadTest(const LoadTestOptions& _options);
+std::string FormatLoadTestReport(const LoadTestOptions& _options, const LoadTestReport& _report);
@@ -11,100 +11,34 @@ Mail : david.fransham@mds.ac.nz
 **************************************************************************/
 
 #include <iostream>
+#include <iomanip>
 #include <windows.h>
 #include <string>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <sstream>
+
+#include "SlotEngine.h"
+#include "PaytableOptimiser.h"
+#include "SecureRandom.h"
+#include "FairnessTests.h"
+#include "SpinExport.h"
+#include "ProgressiveJackpot.h"
+#include "SlotMachineUser.h"
+#include "SlotSession.h"
+#include "LoadGenerator.h"
+#include "SessionSnapshot.h"
+#include "LivePaytable.h"
+#include "ConsoleInput.h"
+#include "AutoPlay.h"
 
 using std::string;
 
-//This class is to hold various variables relating to the user, to avoid using global variables
-class SlotMachineUser
-{
-public:
-	int LastSpin[3] = { 0,0,0 }; //stores the last spin values, for reprinting and keeping UI tidy
-
-	void SetOutput(string _newOutput)
-	{
-		LastOutput = _newOutput;
-	}
-
-	string GetOutput()
-	{
-		return LastOutput;
-	}
-
-	void SetInput(string _newInput)
-	{
-		LastInput = _newInput;
-	}
-
-	string GetInput()
-	{
-		return LastInput;
-	}
-
-	void AddError()
-	{
-		CumulativeInputErrors++;
-	}
-
-	int GetErrors()
-	{
-		return CumulativeInputErrors;
-	}
-
-	void AddChips(int _iChipsToAdd)
-	{
-		CurrentChips += _iChipsToAdd;
-	}
-
-	int GetChips()
-	{
-		return CurrentChips;
-	}
-
-	//negative value to cash out, positive value to buy more
-	void CashInOrOut(int _iAmountChanged)
-	{
-		CurrentChips += _iAmountChanged;
-		CumulativeMoney -= _iAmountChanged;
-	}
-
-	int GetFinancialPosition()
-	{
-		return CumulativeMoney + CurrentChips;
-	}
-
-private:
-	string LastInput; //used to store last input value, for reprinting and keeping UI tidy
-	string LastOutput; //used to store last output value, for reprinting and keeping UI tidy
-	int CumulativeInputErrors = 0; //counts input errors to allow casino security to warn user for repeated infractions
-	int CurrentChips = 0; //stores current value of chips the user has on the table
-	int CumulativeMoney = 0; //keeps track of how much money the user has spent or cashed out
-};
-
 //Constant definitions
-enum ESpinResultCode
-{
-	LOSING_SPIN = 0, //no numbers match (0x bet multiplier)
-	TWO_NUMS_MATCH = 3, //two numbers match (3x bet multiplier)
-	THREE_NUMS_MATCH = 5, //triple but not 7s (5x bet multiplier)
-	JACKPOT_THREE_SEVENS = 10, //triple 7s (10x bet multiplier)
-};
-
-enum class EExitCode
-{
-	OUT_OF_CHIPS,
-	USER_CHOSE_QUIT,
-	TOO_MANY_BAD_INPUTS,
-};
-
-enum class EInputErrors
-{
-	NOT_NUMBER,
-	NOT_ON_MENU,
-	INVALID_BET,
-	NO_INPUT_GIVEN,
-};
+const char* const PAYTABLE_FILE = "paytable.cfg"; //edit while the machine is running to change the payouts, see ParsePaytable for the format
+const char* const PLAYER_SNAPSHOT_FILE = "SlotMachine.snap"; //the player's session is saved here, so chips aren't lost if the machine restarts
 
 enum class EColour
 {
@@ -127,230 +61,584 @@ enum class EColour
 };
 
 //user defined function prototypes
-int GetMenuSelection(SlotMachineUser* _user);
-int GetRandomNumber(int _iMinRand, int _iMaxRand);
-int GetUserInput(SlotMachineUser* _user);
+string AskSessionQuestion(SlotSession* _session);
+string GetMenuSelection(SlotMachineUser* _user);
 int GetScreenWidth();
 int GetScreenHeight();
-int GetSlotWinOrLose(SlotMachineUser* _user);
-bool IsOnlyNumbers(const string& _str);
-bool DoYouWishToContinue(SlotMachineUser* _user);
-string DescribeCurrentPosition(bool _bStillPlaying, int _iMoney);
-
-void RunSlots(SlotMachineUser* _user);
-void CashOutChips(SlotMachineUser* _user);
-void BuyMoreChips(SlotMachineUser* _user);
-void GetUserBet(SlotMachineUser* _user);
+double GetArgumentNumber(int _iArgCount, char* _pArgs[], int _iIndex, double _dDefault);
+bool GetNumberFromString(const string& _str, double* _pValue);
+int RunCommandLineMode(int _iArgCount, char* _pArgs[]);
+int RunPaytableOptimiser(int _iArgCount, char* _pArgs[]);
+int RunFairnessMode(int _iArgCount, char* _pArgs[]);
+int RunSimulationMode(int _iArgCount, char* _pArgs[]);
+int RunJackpotStressMode(int _iArgCount, char* _pArgs[]);
+int RunLoadTestMode(int _iArgCount, char* _pArgs[]);
+int RunPaytableStressMode(int _iArgCount, char* _pArgs[]);
+
+void RunSlots(SlotSession* _session);
+void RunAutoPlay(SlotSession* _session);
+void ShowAutoPlayProgress(SlotMachineUser* _user, const AutoPlaySettings& _settings, const AutoPlayProgress& _progress);
 void GoToXY(int _iX, int _iY);
 void SetRgb(EColour _Colour);
 void ExitSlots(EExitCode _ExitCode, SlotMachineUser* _user);
 void PrintSlotUI(SlotMachineUser* _user, bool _bIncludeLast = true);
-void CheckErrorCounter(int _iErrors, SlotMachineUser* _user);
+void ShowSecurityWarning(int _iErrors);
 void PrintLastSpin(SlotMachineUser* _user);
+void ShowSpinningReels(SlotMachineUser* _user, int _iChipsShown);
 void ClearScreen();
-void InvalidInput(EInputErrors _ErrCode, SlotMachineUser* _user);
-void StartSlots(int _iPlayerBet, SlotMachineUser* _user);
+bool RestorePlayerSession(SlotSession* _session);
+void SavePlayerSession(SlotSession* _session);
 
-int main()
+int main(int argc, char* argv[])
 {
-	//initialising user object and attributes
-	SlotMachineUser playerOne;
-	playerOne.SetInput("Welcome to the GD1P01_22071 Mini Project: Slot Machine!");
-	playerOne.SetOutput("Please gamble wisely.");
-	playerOne.CashInOrOut(2000);
+	//start generating random numbers in the background before anything needs them
+	if (!StartSecureRandomPool())
+	{
+		std::cout << "The secure random number generator could not be seeded.  The machine cannot run.\n";
+		return 1;
+	}
 
-	for (int i = 0; i < 3; i++)
+	//the paytable can be changed while the machine runs by editing the paytable file
+	if (!StartPaytableWatcher(PAYTABLE_FILE))
 	{
-		playerOne.LastSpin[i] = 7;
+		std::cout << PAYTABLE_FILE << " could not be read, so the built in paytable will be used until it is fixed.\n";
 	}
 
-	SlotMachineUser* pSlotUser = &playerOne;
+	//tools for tuning and testing the machine are run from the command line instead of the game
+	if (argc > 1)
+	{
+		return RunCommandLineMode(argc, argv);
+	}
 
-	//seed "random" number generator to increase appearance of randomness
-	srand((unsigned int)time(0));
+	//menus answer on the keypress, rather than waiting for enter
+	StartRawConsoleInput();
 
-	//keeps looping to the main menu while player has money left
-	bool repeatBlock = true;
-	do
+	//initialising user object and attributes.  The user is kept inside a session so it can be saved and restored.
+	SlotSession playerSession;
+	SlotMachineUser& playerOne = playerSession.User;
+	if (RestorePlayerSession(&playerSession)) //the machine stopped part way through someone's session, so carry on from there
 	{
-		while (playerOne.GetChips() > 0)
-		{
-			RunSlots(pSlotUser);
-		}
-
-		if (playerOne.GetChips() == 0)
-		{
-			PrintSlotUI(pSlotUser, true);
+		playerOne.SetInput("Welcome back to the GD1P01_22071 Mini Project: Slot Machine!");
+		playerOne.SetOutput("Your chips are just as you left them.");
+	}
+	else
+	{
+		StartSession(&playerSession);
+	}
 
-			repeatBlock = DoYouWishToContinue(pSlotUser);
-		}
-	} while (repeatBlock); //probably never gets reset to false, but program exits from within functions if this would be false.
+	//keeps asking the session's next question.  The program exits from within ExitSlots once the session ends.
+	while (true)
+	{
+		SavePlayerSession(&playerSession);
+		RunSlots(&playerSession);
+	}
 
 	return 0;
 }
 
-//Asks user to deposit more money when they have run out.  If not, ends program via function call.
-bool DoYouWishToContinue(SlotMachineUser* _user)
+//picks which command line tool to run from the first argument
+int RunCommandLineMode(int _iArgCount, char* _pArgs[])
 {
-	bool inputInvalid = false; //used to loop until valid input is received
-	do
+	string mode = _pArgs[1];
+	if (mode == "optimise")
 	{
-		std::cout << "You ran out of chips.  Would you like to buy more?\n  ";
-		std::cout << "0) No\n  1) Yes\n  ";
-		int userChoice = GetUserInput(_user);
-		if (userChoice == 0)
+		return RunPaytableOptimiser(_iArgCount, _pArgs);
+	}
+	else if (mode == "fairness")
+	{
+		return RunFairnessMode(_iArgCount, _pArgs);
+	}
+	else if (mode == "simulate")
+	{
+		return RunSimulationMode(_iArgCount, _pArgs);
+	}
+	else if (mode == "jackpotstress")
+	{
+		return RunJackpotStressMode(_iArgCount, _pArgs);
+	}
+	else if (mode == "loadtest")
+	{
+		return RunLoadTestMode(_iArgCount, _pArgs);
+	}
+	else if (mode == "paytablestress")
+	{
+		return RunPaytableStressMode(_iArgCount, _pArgs);
+	}
+
+	std::cout << "Unknown mode \"" << mode << "\".  Available modes:\n";
+	std::cout << "  optimise [target return, e.g. 0.95] [threads, 0 for all cores]\n";
+	std::cout << "  fairness [spins, default 1000000000] [threads, 0 for all cores] [generator (default) or spin]\n";
+	std::cout << "  simulate [spins, default 10000000] [bet, default 10] [export file, optional]\n";
+	std::cout << "  jackpotstress [threads, 0 for all cores] [bets per thread, default 10000000] [claim one in, default 64]\n";
+	std::cout << "  loadtest [name=value ...]  players, seconds, threads, think (ms, or min-max), report (file),\n";
+	std::cout << "                             snapshot (file), every (seconds between snapshots), restore (file),\n";
+	std::cout << "                             mix (casual, grinder, troublemaker), play, credits, winnings, cashout, buy, quit, auto,\n";
+	std::cout << "                             invalid\n";
+	std::cout << "  paytablestress [threads, 0 for all cores] [seconds, default 5]\n";
+	return 1;
+}
+
+//reads a number from the command line arguments, or gives back the default if it is missing or not a number
+double GetArgumentNumber(int _iArgCount, char* _pArgs[], int _iIndex, double _dDefault)
+{
+	if (_iIndex >= _iArgCount)
+	{
+		return _dDefault;
+	}
+
+	double value = 0;
+	if (!GetNumberFromString(_pArgs[_iIndex], &value))
+	{
+		std::cout << "Ignoring \"" << _pArgs[_iIndex] << "\" as it is not a number.\n";
+		return _dDefault;
+	}
+	return value;
+}
+
+//converts a whole string to a number, returning false if any of it isn't part of the number
+bool GetNumberFromString(const string& _str, double* _pValue)
+{
+	char* numberEnd = nullptr;
+	double value = std::strtod(_str.c_str(), &numberEnd);
+	if (_str.empty() || *numberEnd != '\0')
+	{
+		return false;
+	}
+	*_pValue = value;
+	return true;
+}
+
+//searches multipliers and reel weights for paytables near a target return, and prints the pareto set found
+int RunPaytableOptimiser(int _iArgCount, char* _pArgs[])
+{
+	PaytableSearchLimits limits;
+	limits.TargetReturnToPlayer = GetArgumentNumber(_iArgCount, _pArgs, 2, limits.TargetReturnToPlayer);
+	int threadCount = (int)GetArgumentNumber(_iArgCount, _pArgs, 3, 0);
+
+	PaytableStats current = BeginPaytableRead().Stats;
+	std::cout << std::fixed << std::setprecision(4);
+	std::cout << "Returns below don't count the progressive jackpot, which is paid on top for bets of $" << JACKPOT_QUALIFYING_BET << " or more.\n";
+	std::cout << "Current paytable: return " << current.ReturnToPlayer << ", hit frequency " << current.HitFrequency
+		<< ", variance " << current.Variance << "\n";
+	std::cout << "Searching for paytables returning " << limits.TargetReturnToPlayer << " (+/- " << limits.ReturnTolerance << ")...\n\n";
+
+	PaytableSearchReport report = OptimisePaytables(limits, threadCount);
+
+	for (const PaytableCandidate& candidate : report.ParetoSet)
+	{
+		std::cout << "return " << candidate.Stats.ReturnToPlayer
+			<< "  hit " << candidate.Stats.HitFrequency
+			<< "  variance " << std::setw(9) << candidate.Stats.Variance
+			<< "  |  two=" << candidate.Paytable.TwoMatchMultiplier
+			<< " three=" << candidate.Paytable.ThreeMatchMultiplier
+			<< " jackpot=" << candidate.Paytable.JackpotMultiplier
+			<< " weights=";
+		for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
 		{
-			ExitSlots(EExitCode::OUT_OF_CHIPS, _user);
+			std::cout << candidate.Paytable.ReelWeights[i] << (i < REEL_SYMBOL_COUNT - 1 ? " " : "\n");
 		}
-		else if (userChoice == 1)
-		{
-			BuyMoreChips(_user);
+	}
 
-			if (_user->GetChips() > 0) //chips went to 0 but player bought more, so return true for "do you want to continue
-			{
-				return true;
-			}
-			else //chips went to 0, user said they want to buy more, but didn't actually buy any.  Assumes they chose to leave instead.
-			{
-				ExitSlots(EExitCode::OUT_OF_CHIPS, _user);
-			}
+	std::cout << "\n" << report.ParetoSet.size() << " paytables in the pareto set.\n";
+	std::cout << report.CandidatesEvaluated << " candidates evaluated in " << report.SecondsTaken << " seconds on "
+		<< report.ThreadsUsed << " threads (" << std::setprecision(0) << report.CandidatesEvaluated / report.SecondsTaken
+		<< " per second).\n";
+	return 0;
+}
+
+//runs the statistical fairness tests over the reels and prints a pass/fail report.  Returns 0 only if every test passed.
+//draws come straight from a generator on each thread unless "spin" is given, which goes through the real spin path's
+//shared buffer - every draw queues on it, so that is only worth doing for a much shorter run.
+int RunFairnessMode(int _iArgCount, char* _pArgs[])
+{
+	long long spinCount = (long long)GetArgumentNumber(_iArgCount, _pArgs, 2, 1e9);
+	int threadCount = (int)GetArgumentNumber(_iArgCount, _pArgs, 3, 0);
+	string drawPathName = _iArgCount > 4 ? _pArgs[4] : "generator";
+	EFairnessDrawPath drawPath = EFairnessDrawPath::GENERATOR_ONLY;
+	if (drawPathName == "spin")
+	{
+		drawPath = EFairnessDrawPath::SPIN_PATH;
+	}
+	else if (drawPathName != "generator")
+	{
+		std::cout << "Ignoring \"" << drawPathName << "\", drawing straight from the generator.\n";
+	}
+
+	StopPaytableWatcher(); //the reels are tested on the paytable in play now, so it mustn't change part way through
+	const SlotPaytable& paytable = BeginPaytableRead().Paytable;
+	std::cout << "Testing " << spinCount << " spins (" << spinCount * REEL_COUNT << " reel draws) "
+		<< (drawPath == EFairnessDrawPath::SPIN_PATH ? "through the spin path" : "straight from the generator")
+		<< " on paytable version " << BeginPaytableRead().Version << ", reel weights";
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		std::cout << " " << paytable.ReelWeights[i];
+	}
+	std::cout << "...\n\n";
+	FairnessReport report = RunFairnessTests(spinCount, threadCount, drawPath);
+
+	for (const FairnessTestResult& result : report.Results)
+	{
+		std::cout << std::left << std::setw(40) << result.Name << std::right;
+		if (result.DegreesOfFreedom > 0)
+		{
+			std::cout << "chi-square " << std::fixed << std::setprecision(2) << std::setw(10) << result.Statistic
+				<< " (df " << std::setw(3) << result.DegreesOfFreedom << ")";
 		}
-		else //triggers if input is negative (indicating input error), or outside range (item not on menu)
+		else
 		{
-			inputInvalid = true; //repeat loop for valid input
+			std::cout << "z score    " << std::fixed << std::setprecision(2) << std::setw(10) << result.Statistic << "         ";
 		}
-	} while (inputInvalid);
+		std::cout << "  p = " << std::setprecision(6) << result.PValue << "  " << (result.Passed ? "PASS" : "FAIL") << "\n";
+	}
 
-	return false; //theoretically shouldn't get to here, as code above either returns true or exits via function call
+	std::cout << "\n" << report.SpinsTested << " spins tested in " << std::setprecision(2) << report.SecondsTaken << " seconds on "
+		<< report.ThreadsUsed << " threads (" << std::setprecision(0) << report.SpinsTested * REEL_COUNT / report.SecondsTaken
+		<< " draws per second).\n";
+	if (!report.AllOnTestedPaytable)
+	{
+		std::cout << "The paytable changed while the tests were starting, so the results can't be trusted.\n";
+	}
+	if (report.DrawPath == EFairnessDrawPath::SPIN_PATH)
+	{
+		std::cout << report.FallbackDraws << " random words were generated on the spin thread because the buffer was empty.\n";
+	}
+	std::cout << "A test fails if its p-value is below " << std::setprecision(4) << FAIRNESS_SIGNIFICANCE
+		<< " (or above " << 1.0 - FAIRNESS_SIGNIFICANCE << " for chi-square, as a fit that good is suspicious too).\n";
+	std::cout << (report.AllPassed ? "RESULT: PASS\n" : "RESULT: FAIL\n");
+	return report.AllPassed ? 0 : 1;
 }
 
-//this function handles the calling of other functions to make the slot machine run
-void RunSlots(SlotMachineUser* _user)
+//spins the reels with no display as fast as possible, optionally exporting every spin to a file for analysis.
+//when exporting, the file is read back afterwards to check it matches what was simulated, spin by spin.
+int RunSimulationMode(int _iArgCount, char* _pArgs[])
 {
-	PrintSlotUI(_user, true);
+	long long spinCount = (long long)GetArgumentNumber(_iArgCount, _pArgs, 2, 1e7);
+	int bet = (int)GetArgumentNumber(_iArgCount, _pArgs, 3, 10);
+	string exportFile = _iArgCount > 4 ? _pArgs[4] : "";
+	const long long startBalance = STARTING_CHIPS;
 
-	int playerChoice = GetMenuSelection(_user);
-	string currentProfitLoss;
+	SpinExportWriter writer;
+	if (!exportFile.empty() && !writer.Open(exportFile, startBalance))
+	{
+		std::cout << "Could not create export file " << exportFile << "\n";
+		return 1;
+	}
 
-	switch (playerChoice)
+	long long balance = startBalance;
+	long long totalPaid = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (long long i = 0; i < spinCount; ++i)
 	{
-	case -1: //input not a number - handled by other function, included here to exclude it from default
-		break;
-	case 1: //Play Slots - calls the slot function
-		GetUserBet(_user);
-		break;
-	case 2: //Credits
-		_user->SetOutput("This program was written by David Fransham, 2022\n\n  ");
-		std::cout << _user->GetOutput();
-		break;
-	case 3: //Quit
-		ExitSlots(EExitCode::USER_CHOSE_QUIT, _user);
-		return; //probably not necessary as I know this function exits the program, but included for clarity of code
-	case 4: //display profit tracker 
-		currentProfitLoss = DescribeCurrentPosition(true, _user->GetFinancialPosition());
-		_user->SetOutput(currentProfitLoss);
-		std::cout << _user->GetOutput();
-		break;
-	case 5: //Cash Out
-		CashOutChips(_user);
-		break;
-	case 6: //deposit more, only available if chips <= 500.
-		if (_user->GetChips() <= 500)
+		int slotNums[REEL_COUNT];
+		const SlotPaytable& paytable = BeginPaytableRead().Paytable;
+		GetProgressiveJackpot().Contribute(bet);
+		ESpinResultCode result = SpinReels(paytable, slotNums);
+		long long payout = (long long)bet * GetPayoutMultiplier(paytable, result); //can pass an int on a big paytable
+		if (result == JACKPOT_THREE_SEVENS)
 		{
-			BuyMoreChips(_user);
-			break; //falls through to default if 5 is not on the menu
+			payout += GetProgressiveJackpot().ClaimJackpot(bet);
+		}
+		balance += payout - bet;
+		totalPaid += payout;
+
+		if (!exportFile.empty())
+		{
+			writer.AddSpin(slotNums, result, bet, payout, balance);
 		}
-	default: //should only be numbers that are not menu items
-		InvalidInput(EInputErrors::NOT_ON_MENU, _user);
-		break;
 	}
-	return;
+	if (!exportFile.empty() && !writer.Close())
+	{
+		std::cout << "Writing to " << exportFile << " failed.\n";
+		return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	std::cout << std::fixed << std::setprecision(4);
+	std::cout << spinCount << " spins at $" << bet << ": return " << (double)totalPaid / ((double)bet * spinCount)
+		<< ", final balance $" << balance << "\n";
+	std::cout << std::setprecision(2) << seconds << " seconds (" << std::setprecision(0) << spinCount / seconds << " spins per second"
+		<< (exportFile.empty() ? ", not exporting" : ", exporting") << ").\n";
+
+	if (exportFile.empty())
+	{
+		return 0;
+	}
+
+	//read the file back and check it against the simulation
+	SpinExportReader reader;
+	if (!reader.Open(exportFile))
+	{
+		std::cout << "Could not read back " << exportFile << "\n";
+		return 1;
+	}
+
+	startTime = std::chrono::steady_clock::now();
+	SpinRecord record;
+	long long spinsRead = 0;
+	long long paidRead = 0;
+	long long lastBalance = reader.GetStartBalance();
+	bool spinsAddUp = true; //every spin's balance moved by exactly its payout less its bet
+	while (reader.NextSpin(record))
+	{
+		spinsRead++;
+		paidRead += (long long)record.Payout;
+		spinsAddUp = spinsAddUp && record.Balance - lastBalance == (long long)record.Payout - (long long)record.Bet;
+		lastBalance = record.Balance;
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	bool matches = spinsAddUp && spinsRead == spinCount && (long long)reader.GetSpinCount() == spinCount && paidRead == totalPaid && lastBalance == balance;
+	std::cout << "Read back " << spinsRead << " spins in " << std::setprecision(2) << seconds << " seconds - "
+		<< (matches ? "matches the simulation.\n" : "DOES NOT match the simulation!\n");
+	return matches ? 0 : 1;
+}
+
+//hammers a progressive jackpot from every core and checks no contribution was lost and no pool was paid twice
+int RunJackpotStressMode(int _iArgCount, char* _pArgs[])
+{
+	int threadCount = (int)GetArgumentNumber(_iArgCount, _pArgs, 2, 0);
+	long long betsPerThread = (long long)GetArgumentNumber(_iArgCount, _pArgs, 3, 1e7);
+	int claimOneIn = (int)GetArgumentNumber(_iArgCount, _pArgs, 4, 64);
+
+	JackpotStressReport report = RunJackpotStressTest(threadCount, betsPerThread, claimOneIn);
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << report.Contributions << " contributions and " << report.Claims << " jackpot claims in " << report.SecondsTaken
+		<< " seconds (" << std::setprecision(0) << report.Contributions / report.SecondsTaken << " contributions per second).\n";
+	std::cout << "No contribution lost or double counted: " << (report.NothingLost ? "PASS" : "FAIL") << "\n";
+	std::cout << "Exactly one winner per pool:            " << (report.OneWinnerPerPool ? "PASS" : "FAIL") << "\n";
+	return (report.NothingLost && report.OneWinnerPerPool) ? 0 : 1;
+}
+
+//swaps paytables as fast as possible while every core spins on them, and checks no spin saw half of one
+int RunPaytableStressMode(int _iArgCount, char* _pArgs[])
+{
+	int threadCount = (int)GetArgumentNumber(_iArgCount, _pArgs, 2, 0);
+	double seconds = GetArgumentNumber(_iArgCount, _pArgs, 3, 5);
+
+	StopPaytableWatcher(); //the test publishes its own paytables
+	PaytableStressReport report = RunPaytableStressTest(threadCount, seconds);
+
+	std::cout << report.SpinsChecked << " spins checked while " << report.PaytablesPublished << " paytables were published in "
+		<< std::fixed << std::setprecision(2) << report.SecondsTaken << " seconds.\n";
+	std::cout << "Every spin saw one whole paytable: " << (report.NoTornReads ? "yes" : "NO") << "\n";
+	std::cout << "Every replaced paytable freed: " << (report.AllFreed ? "yes" : "NO") << " (" << report.PaytablesFreed << " freed)\n";
+	return report.NoTornReads && report.AllFreed ? 0 : 1;
 }
 
-//allows user to buy more chips, subtracting the amount they buy from the profit/loss tracking variable in the process
-void BuyMoreChips(SlotMachineUser* _user)
+//runs virtual players through headless sessions and reports throughput and latency.
+//settings are given as name=value, e.g. "loadtest players=50000 seconds=30 think=50-500 mix=grinder report=before.txt"
+int RunLoadTestMode(int _iArgCount, char* _pArgs[])
 {
-	bool repeatBlock = false;
-	do
+	LoadTestOptions options;
+	string reportFile;
+	std::vector<std::pair<string, int>> weightChanges; //applied after the mix is picked, whatever order they were given in
+
+	for (int i = 2; i < _iArgCount; ++i)
 	{
-		std::cout << "How many more chips would you like to buy? (Max 5000)\n  ";
-		int moreChips = GetUserInput(_user);
-		if (moreChips == 0)
+		string argument = _pArgs[i];
+		size_t equals = argument.find('=');
+		string name = argument.substr(0, equals);
+		string value = equals == string::npos ? "" : argument.substr(equals + 1);
+		double number = -1;
+		bool isNumber = GetNumberFromString(value, &number) && number >= 0;
+
+		if (name == "players" && isNumber)
 		{
-			return;
+			options.PlayerCount = (int)number;
 		}
-		else if (moreChips < 0)
+		else if (name == "seconds" && isNumber)
 		{
-			repeatBlock = true;
+			options.DurationSeconds = number;
 		}
-		else if (moreChips >= 5000)
+		else if (name == "threads" && isNumber)
 		{
-			_user->SetOutput("You have purchased the maximum number of chips allowed, 5000.\n  ");
-			std::cout << _user->GetOutput();
-			_user->CashInOrOut(5000);
-			break;
+			options.ThreadCount = (int)number;
 		}
-		else
+		else if (name == "think")
 		{
-			string tempStr = "You purchased $";
-			tempStr += std::to_string(moreChips);
-			tempStr += " more chips.\n  ";
-			_user->SetOutput(tempStr);
-			std::cout << _user->GetOutput();
-
-			_user->CashInOrOut(moreChips);
-			break;
+			size_t dash = value.find('-');
+			double minThink = 0;
+			double maxThink = 0;
+			GetNumberFromString(value.substr(0, dash), &minThink);
+			maxThink = minThink;
+			if (dash != string::npos)
+			{
+				GetNumberFromString(value.substr(dash + 1), &maxThink);
+			}
+			options.ThinkTimeMinMs = (int)minThink;
+			options.ThinkTimeMaxMs = (int)maxThink;
 		}
-	} while (repeatBlock);
-	return;
-}
-
-//allows user to cash out some of their chips, adding the amount to the profit/loss tracker.
-//this is to simulate the user taking some profit on their winnings to ensure they don't make a loss overall later
-void CashOutChips(SlotMachineUser* _user)
-{
-	bool repeatBlock = false;
-	do
-	{
-		int chipsNow = _user->GetChips();
-		std::cout << "How much would you like to cash out?\n  ";
-		int lessChips = GetUserInput(_user);
-		if (lessChips == 0)
+		else if (name == "mix" && GetVirtualPlayerMix(value, &options.Mix))
+		{
+			options.MixName = value;
+		}
+		else if (name == "report" && !value.empty())
+		{
+			reportFile = value;
+		}
+		else if (name == "snapshot" && !value.empty())
 		{
-			_user->SetOutput("You chose to return to the casino without cashing anything out.\n  ");
-			std::cout << _user->GetOutput();
-			return;
+			options.SnapshotFile = value;
 		}
-		else if (lessChips < 0) //ignored because -1 means bad input
+		else if (name == "every" && isNumber)
 		{
-			repeatBlock = true;
+			options.SnapshotIntervalSeconds = number;
 		}
-		else if (lessChips >= chipsNow) //user chose to cash out all their chips
+		else if (name == "restore" && !value.empty())
+		{
+			options.RestoreFile = value;
+		}
+		else if ((name == "play" || name == "credits" || name == "winnings" || name == "cashout"
+			|| name == "buy" || name == "quit" || name == "auto" || name == "invalid") && isNumber)
+		{
+			weightChanges.push_back(std::make_pair(name, (int)number));
+		}
+		else
 		{
-			ExitSlots(EExitCode::USER_CHOSE_QUIT, _user);
+			std::cout << "Ignoring \"" << argument << "\".\n";
 		}
-		else  //all that's left is: 0 < chip value entered < max chips held
+	}
+
+	for (const std::pair<string, int>& change : weightChanges)
+	{
+		VirtualPlayerMix& mix = options.Mix;
+		int* weight = change.first == "play" ? &mix.PlayWeight
+			: change.first == "credits" ? &mix.CreditsWeight
+			: change.first == "winnings" ? &mix.WinningsWeight
+			: change.first == "cashout" ? &mix.CashOutWeight
+			: change.first == "buy" ? &mix.BuyChipsWeight
+			: change.first == "quit" ? &mix.QuitWeight
+			: change.first == "auto" ? &mix.AutoPlayWeight
+			: &mix.InvalidPercent;
+		*weight = change.second;
+		options.MixName += "," + change.first + "=" + std::to_string(change.second);
+	}
+
+	if (options.RestoreFile.empty())
+	{
+		std::cout << "Running " << options.PlayerCount << " virtual players for " << options.DurationSeconds << " seconds...\n\n";
+	}
+	else
+	{
+		std::cout << "Restoring virtual players from " << options.RestoreFile << " and running them for " << options.DurationSeconds << " seconds...\n\n";
+	}
+	LoadTestReport report = RunLoadTest(options);
+	if (report.RestoreFailed)
+	{
+		std::cout << "Could not restore sessions from " << options.RestoreFile << ", it is missing or damaged.\n";
+		return 1;
+	}
+	string reportText = FormatLoadTestReport(options, report);
+	std::cout << reportText;
+
+	if (!reportFile.empty())
+	{
+		std::ofstream file(reportFile);
+		file << reportText;
+		if (!file.good())
 		{
-			string tempStr = "You cashed out ";
-			tempStr += std::to_string(lessChips);
-			tempStr += " and return to the casino.\n  ";
-
-			_user->CashInOrOut(lessChips * -1);
-			chipsNow = _user->GetChips();
-
-			tempStr += "You still have ";
-			tempStr += std::to_string(chipsNow);
-			_user->SetOutput(tempStr);
-			std::cout << _user->GetOutput();
-			break;
+			std::cout << "Could not write report to " << reportFile << "\n";
+			return 1;
 		}
-	} while (repeatBlock);
+	}
+	if (report.SnapshotsFailed)
+	{
+		std::cout << "Could not write snapshots to " << options.SnapshotFile << "\n";
+		return 1;
+	}
+	return 0;
+}
 
+//this function handles the calling of other functions to make the slot machine run.  The session decides what happens
+//with each answer - this shows its question, reads the answer, and shows anything that needs more than a redraw.
+void RunSlots(SlotSession* _session)
+{
+	SlotMachineUser* user = &_session->User;
+	switch (_session->State)
+	{
+	case ESessionState::ENDED:
+		ExitSlots(_session->ExitCode, user);
+		return; //probably not necessary as I know this function exits the program, but included for clarity of code
+	case ESessionState::AUTO_PLAYING:
+		RunAutoPlay(_session);
+		return;
+	case ESessionState::AWAITING_ACKNOWLEDGEMENT:
+		ShowSecurityWarning(user->GetErrors());
+		HandleSessionInput(_session, ""); //any key acknowledges it
+		return;
+	default:
+		break;
+	}
+
+	PrintSlotUI(user, true);
+	HandleSessionInput(_session, AskSessionQuestion(_session));
+
+	if (_session->LastEvent == ESessionEvent::SPIN_PLAYED)
+	{
+		//the bet, the reels and the winnings go to disk together before anything is shown, so closing the console part way
+		//through the animation can't lose a bet or change the outcome - the restored session has the spin already paid.
+		SavePlayerSession(_session);
+		ShowSpinningReels(user, user->GetChips() - _session->LastWinnings);
+	}
+	else if (_session->LastEvent == ESessionEvent::CREDITS_SHOWN) //plus how quickly the machine has been answering key presses
+	{
+		KeyLatencyStats latency = GetKeyLatencyStats();
+		std::ostringstream credits;
+		credits << std::fixed << std::setprecision(2);
+		credits << user->GetOutput();
+		credits << "Key presses were echoed " << latency.LastMilliseconds << "ms after the console signalled them (worst " << latency.WorstMilliseconds
+			<< "ms over " << latency.KeysTimed << " keys)\n\n  ";
+		user->SetOutput(credits.str());
+	}
 	return;
 }
 
-//print menu, calls for input, returns input value
-int GetMenuSelection(SlotMachineUser* _user)
+//prints the question the session is waiting on, and returns what the user answered.
+//menus where every option is one digit act as soon as a key is pressed, amounts are typed in and end with enter.
+string AskSessionQuestion(SlotSession* _session)
+{
+	switch (_session->State)
+	{
+	case ESessionState::AT_MENU:
+		return GetMenuSelection(&_session->User);
+	case ESessionState::AWAITING_BET:
+		std::cout << "How much would you like to bet? (0 to go back to main menu)\n  ";
+		std::cout << "Bets of $" << JACKPOT_QUALIFYING_BET << " or more can win the progressive jackpot.\n  ";
+		return ReadAmountInPlace();
+	case ESessionState::AWAITING_PURCHASE:
+	case ESessionState::AWAITING_TOP_UP_PURCHASE:
+		std::cout << "How many more chips would you like to buy? (Max " << MAX_CHIP_PURCHASE << ")\n  ";
+		return ReadAmountInPlace();
+	case ESessionState::AWAITING_CASH_OUT:
+		std::cout << "How much would you like to cash out?\n  ";
+		return ReadAmountInPlace();
+	case ESessionState::AWAITING_TOP_UP_CHOICE:
+		std::cout << "You ran out of chips.  Would you like to buy more?\n  ";
+		std::cout << "0) No\n  1) Yes\n  ";
+		return ReadKeyChoice();
+	case ESessionState::AWAITING_AUTO_SPIN_COUNT:
+		std::cout << "How many spins would you like to auto play? (0 to go back to main menu)\n  ";
+		return ReadAmountInPlace();
+	case ESessionState::AWAITING_AUTO_BET:
+		std::cout << "How much would you like to bet on each spin? (0 to go back to main menu)\n  ";
+		return ReadAmountInPlace();
+	case ESessionState::AWAITING_AUTO_BALANCE_FLOOR:
+		std::cout << "Stop before your chips drop below how many? (0 for no limit)\n  ";
+		return ReadAmountInPlace();
+	case ESessionState::AWAITING_AUTO_WIN_LIMIT:
+		std::cout << "Stop after winning more than how much on one spin? (0 for no limit)\n  ";
+		return ReadAmountInPlace();
+	case ESessionState::AWAITING_AUTO_JACKPOT_CHOICE:
+		std::cout << "Stop if you hit the jackpot?\n  0) No\n  1) Yes\n  ";
+		return ReadKeyChoice();
+	default: //the other states don't ask anything, and RunSlots deals with them before asking
+		return "";
+	}
+}
+
+//print menu, then returns the key pressed
+string GetMenuSelection(SlotMachineUser* _user)
 {
 	GoToXY(2, 17);
 	std::cout << "1) Play Slots!\n  ";
@@ -358,78 +646,76 @@ int GetMenuSelection(SlotMachineUser* _user)
 	std::cout << "3) Quit Slot Machine\n  ";
 	std::cout << "4) Show Today's Winnings (or Losses)\n  ";
 	std::cout << "5) Cash Out\n  ";
-	if (_user->GetChips() <= 500) //only shows if user has 500 or fewer chips
+	if (_user->GetChips() <= TOP_UP_CHIP_LIMIT) //only shows if user has 500 or fewer chips
 	{
 		std::cout << "6) Buy More Chips\n  ";
 	}
-	return GetUserInput(_user);
+	std::cout << "7) Auto Play\n  ";
+	return ReadKeyChoice();
 }
 
-//rather than having multiple checks every time I want to cin, this function is called to take input and validate the data type
-//the only input I need in this program is numbers, so this function takes a line of input from cin, checks it is all numbers and returns
-int GetUserInput(SlotMachineUser* _user)
+//plays the spins of an auto play run without coming back to the menu.  The screen is only redrawn a few times a second,
+//and any key stops it early.  The chips are saved at each redraw and when the run ends, so if the console is closed
+//part way through, the session comes back at the menu as it was at the last redraw - only the spins since then are lost.
+void RunAutoPlay(SlotSession* _session)
 {
-	string tempStr;
-	std::getline(std::cin, tempStr);
-	std::cout << "  ";
-
-	_user->SetInput(tempStr);
-	if (tempStr.empty())  //user pressed enter without any input first
-	{
-		InvalidInput(EInputErrors::NO_INPUT_GIVEN, _user);
-		return -1;
-	}
-	else if (IsOnlyNumbers(tempStr))  //string to integer for valid numerical input
-	{
-		return stoi(tempStr);
-	}
-	else  //user entered non-numerical input value (includes . and - as non-valid)
-	{
-		InvalidInput(EInputErrors::NOT_NUMBER, _user);
-		return -1;
+	SlotMachineUser* user = &_session->User;
+	PrintSlotUI(user, false);
+
+	//spins as fast as they can be played, only going back to the screen and keyboard a few times a second
+	typedef std::chrono::steady_clock Clock;
+	const Clock::duration refreshInterval = std::chrono::milliseconds(1000 / AUTO_PLAY_REFRESHES_PER_SECOND);
+	Clock::time_point lastRefresh = Clock::now();
+	ShowAutoPlayProgress(user, _session->AutoPlay, _session->AutoProgress);
+	while (PlaySessionAutoSpin(_session))
+	{
+		Clock::time_point now = Clock::now();
+		if (now - lastRefresh >= refreshInterval)
+		{
+			lastRefresh = now;
+			ShowAutoPlayProgress(user, _session->AutoPlay, _session->AutoProgress);
+			SavePlayerSession(_session);
+			if (PollKey() != KEY_NONE)
+			{
+				HandleSessionInput(_session, ""); //any key stops the run, and the next spin finds it stopped
+			}
+		}
 	}
+	ShowAutoPlayProgress(user, _session->AutoPlay, _session->AutoProgress);
+	return;
 }
 
-//Asks user for a value to bet on the slots.  Will handle invalid input.
-void GetUserBet(SlotMachineUser* _user)
+//updates just the parts of the screen auto play changes - chips, jackpot, reels and the running totals - rather than redrawing it all
+void ShowAutoPlayProgress(SlotMachineUser* _user, const AutoPlaySettings& _settings, const AutoPlayProgress& _progress)
 {
-	int chipsNow = _user->GetChips();
-	int inputBet;
+	SetRgb(EColour::COLOUR_CYAN_ON_BLACK);
+	GoToXY(2, 2);
+	std::cout << " Your chips: $" << _user->GetChips() << "          ";
 
-	//infinite loop so function runs again after invalid input
-	while (true)
-	{
-		std::cout << "How much would you like to bet? (0 to go back to main menu)\n  ";
+	SetRgb(EColour::COLOUR_YELLOW_ON_BLACK);
+	GoToXY(2, 3);
+	std::cout << " Jackpot: $" << GetProgressiveJackpot().GetPoolChips() << "          ";
 
-		inputBet = GetUserInput(_user);
-		if (inputBet == 0)  //user got cold feet and decided not to gamble just now
-		{
-			_user->SetOutput("You have chosen to return to the previous menu.\n  ");
-			std::cout << _user->GetOutput();
-			break;
-		}
-		else if (inputBet < 0)
-		{	//deliberately runs no code as negative value only arises from bad input
-			//this if statement catches the bad input and returns to the infite loop to try again
-		}
-		else if (inputBet > chipsNow) //User tried to bet more than they have available
-		{
-			InvalidInput(EInputErrors::INVALID_BET, _user);
-		}
-		else
-		{
-			StartSlots(inputBet, _user);
-			break;
-		}
-	}
+	PrintLastSpin(_user);
+
+	SetRgb(EColour::COLOUR_GREEN_ON_BLACK);
+	GoToXY(2, 14);
+	std::cout << "Spin " << _progress.SpinsPlayed << " of " << _settings.SpinCount << "   Wins: " << _progress.Wins
+		<< "   Biggest win: $" << _progress.BiggestWin << "          ";
+	GoToXY(2, 15);
+	std::cout << "Total bet: $" << _progress.TotalBet << "   Total won: $" << _progress.TotalWon << "          ";
+	std::cout.flush();
 	return;
 }
 
-//function to spin the slots, print the numbers, and return a value showing the win code
-int GetSlotWinOrLose(SlotMachineUser* _user)
+//plays the reels spinning into place, one at a time, landing on the numbers already in the user's last spin.
+//the chips shown while they spin are the ones given, so a win isn't given away before the reels land.
+void ShowSpinningReels(SlotMachineUser* _user, int _iChipsShown)
 {
 	PrintSlotUI(_user, false);
-	int slotNums[3];
+	SetRgb(EColour::COLOUR_CYAN_ON_BLACK);
+	GoToXY(2, 2);
+	std::cout << " Your chips: $" << _iChipsShown << "          ";
 
 	SetRgb(EColour::COLOUR_RED_ON_BLACK);
 
@@ -440,15 +726,14 @@ int GetSlotWinOrLose(SlotMachineUser* _user)
 		std::cout << " ";
 	}
 
-	//generates the three random numbers, stores the values in an array
+	//shows the numbers already spun, one at a time
 	for (int j = 0; j < 3; j++)
 	{
-		slotNums[j] = GetRandomNumber(2, 7);
 		Sleep(1001); //simulate the wheels spinning into place by taking time
 
-		//print the newly generated value to the screen
+		//print the landed value to the screen
 		GoToXY((GetScreenWidth() / 2 - 5 + (5 * j)), 6);
-		if (slotNums[j] == 7)
+		if (_user->LastSpin[j] == 7)
 		{
 			SetRgb(EColour::COLOUR_RED_ON_BLACK);
 		}
@@ -456,76 +741,10 @@ int GetSlotWinOrLose(SlotMachineUser* _user)
 		{
 			SetRgb(EColour::COLOUR_BLUE_ON_BLACK);
 		}
-		std::cout << slotNums[j];
-		_user->LastSpin[j] = slotNums[j];
+		std::cout << _user->LastSpin[j];
 	}
 
 	PrintSlotUI(_user);
-
-	//checks the array to see if it is a winner or not
-	//on relfection, this would be better as a separate function with a pointer to work with, but I ran out of time to implement this change
-	if ((slotNums[0] == slotNums[1]) && (slotNums[1] == slotNums[2]))
-	{
-		if (slotNums[1] == 7)
-		{
-			return JACKPOT_THREE_SEVENS;
-		}
-		else
-		{
-			return THREE_NUMS_MATCH;
-		}
-	}
-	else if ((slotNums[0] == slotNums[1]) || (slotNums[0] == slotNums[2]) || (slotNums[1] == slotNums[2]))
-	{
-		return TWO_NUMS_MATCH;
-	}
-	else
-	{
-		return LOSING_SPIN;
-	}
-}
-
-//takes players bet as argument, calls the slot function and calculates result
-void StartSlots(int playerBet, SlotMachineUser* _user)
-{
-	_user->AddChips(playerBet * -1); //subtract bet that was put in the slotmachine
-	int spinResult;
-	spinResult = GetSlotWinOrLose(_user);
-
-	SetRgb(EColour::COLOUR_GREEN_ON_BLACK);
-	std::cout << "\n\n  ";
-
-	string tempStr = "";
-	switch (spinResult)
-	{
-	case LOSING_SPIN:
-		tempStr += "Sorry, you did not win this time.\n\n  ";
-		break;
-	case TWO_NUMS_MATCH:
-		tempStr += "You matched two numbers, and won three times your bet!\n  ";
-		break;
-	case THREE_NUMS_MATCH:
-		tempStr += "You matched three numbers, and won five times your bet!\n  ";
-		break;
-	case JACKPOT_THREE_SEVENS:
-		tempStr += "You hit the jackpot and spun three 7s!  You won 10 times your bet!\n  ";
-		break;
-	default:
-		std::cout << "Something unexpected happened, please contact the developer for more info\n  ";
-		break;
-	}
-
-	if (spinResult != LOSING_SPIN)
-	{
-		int winnings = (playerBet * spinResult);
-		tempStr += "You receive $";
-		tempStr += std::to_string(winnings);
-
-		_user->AddChips(winnings); //return any winnings to the player's pot
-	}
-	_user->SetOutput(tempStr);
-	std::cout << _user->GetOutput();
-
 	return;
 }
 
@@ -561,6 +780,11 @@ void PrintSlotUI(SlotMachineUser* _user, bool _bIncludeLast)
 	GoToXY(2, 2);
 	std::cout << " Your chips: $" << _user->GetChips();
 
+	//print the progressive jackpot underneath
+	SetRgb(EColour::COLOUR_YELLOW_ON_BLACK);
+	GoToXY(2, 3);
+	std::cout << " Jackpot: $" << GetProgressiveJackpot().GetPoolChips();
+
 	//print slot machine outline
 	SetRgb(EColour::COLOUR_YELLOW_ON_BLACK);
 	GoToXY((GetScreenWidth() / 2 - 8), 4);
@@ -610,87 +834,6 @@ void PrintLastSpin(SlotMachineUser* _user)
 	return;
 }
 
-//prints relevant error messages after input validation during code
-void InvalidInput(EInputErrors ErrCode, SlotMachineUser* _user)
-{
-	SetRgb(EColour::COLOUR_MAGENTA_ON_BLACK);
-	switch (ErrCode)
-	{
-	case EInputErrors::NOT_NUMBER:
-		_user->SetOutput("-----Please enter a positive whole number with no other characters-----\n\n  ");
-		std::cout << _user->GetOutput();
-		break;
-	case EInputErrors::NOT_ON_MENU:
-		_user->SetOutput("-----Please enter a number that matches a menu option.-----\n\n  ");
-		std::cout << _user->GetOutput();
-		break;
-	case EInputErrors::INVALID_BET:
-		_user->SetOutput("-----You can't bet more than you have.-----\n\n  ");
-		std::cout << _user->GetOutput();
-		break;
-	case EInputErrors::NO_INPUT_GIVEN:
-		_user->SetOutput("-----You just hit enter without any input.-----\n\n  ");
-		std::cout << _user->GetOutput();
-		break;
-	default: //shouldn't be called, but in case of changes in future this will be picked up.
-		std::cout << "\n  Something unexpected happened.  See developer for more info.\n\n  ";
-		break;
-	}
-	_user->AddError();
-	CheckErrorCounter(_user->GetErrors(), _user);
-	PrintSlotUI(_user);
-	SetRgb(EColour::COLOUR_GREEN_ON_BLACK);
-}
-
-//prints a string to display how much money the user has made or lost today.
-//Takes a boolean argument to assess whether they are still playing or whether they are leaving casino now
-string DescribeCurrentPosition(bool _bStillPlaying, int _iMoney)
-{
-	string profitLossDescription = "You ";
-
-	//int temp = g_CumulativeSpendOrWin;
-	//temp += CurrentChips;
-
-	if (_iMoney == 0)
-	{
-		if (_bStillPlaying)
-		{
-			profitLossDescription += "are breaking";
-		}
-		else //if !stillplaying
-		{
-			profitLossDescription += "broke";
-		}
-
-		profitLossDescription += " even today, not bad.\n  ";
-		return profitLossDescription;  //should be "You are breaking even today, not bad." or "You broke even today, not bad."
-	}
-	else //if money != 0
-	{
-		if (_bStillPlaying)
-		{
-			profitLossDescription += "are making";
-		}
-		else //if !stillplaying
-		{
-			profitLossDescription += "made";
-		}
-	}
-
-	if (_iMoney < 0)
-	{
-		profitLossDescription += " an overall loss today of ";
-	}
-	else //if (money > 0).  == 0 won't occur because it was in the separate if statement above and has already been returned.
-	{
-		profitLossDescription += " overall winnings today of ";
-	}
-
-	profitLossDescription += std::to_string(_iMoney);
-	profitLossDescription += ".\n  ";
-	return profitLossDescription; //Should be "You are making/made an overal loss today of xxxx" or "You are making/made overall winnings today of xxxx"
-}
-
 //function to handle the various exit messages when ending the program
 void ExitSlots(EExitCode eCode, SlotMachineUser* _user)
 {
@@ -724,11 +867,13 @@ void ExitSlots(EExitCode eCode, SlotMachineUser* _user)
 		break;
 	}
 
-	//pauses to allow user to read screen and hit enter to close program
-	do
-	{
-		std::cout << '\n' << "  Press the Enter key to exit.";
-	} while (std::cin.get() != '\n');
+	//the session is over, so the next player starts fresh instead of picking this one up
+	DeleteFileA(PLAYER_SNAPSHOT_FILE);
+
+	//pauses to allow user to read screen and press a key to close program
+	std::cout << '\n' << "  Press any key to exit.";
+	std::cout.flush();
+	WaitForKey();
 
 	exit(0);
 }
@@ -818,43 +963,47 @@ void SetRgb(EColour colour)
 }
 
 //Casino security don't like it if you keep trying to break the machines...
-void CheckErrorCounter(int _iErrors, SlotMachineUser* _user)
+//shows the warning for the number of errors the session stopped at, and waits for the user to take it in
+void ShowSecurityWarning(int _iErrors)
 {
-	string temp; //placeholder to wait for user to hit enter to continue
-	if (_iErrors == 4)
-	{
-		ClearScreen();
-		SetRgb(EColour::COLOUR_RED_ON_BLACK);
-		std::cout << "\n\n\n\tCasino Security have been notified of disruption in the casino.\n\n";
-		std::cout << "\tA security guard approaches you and asks you politely to follow the directions.\n\n";
-		std::cout << "\tPress Enter to continue.";
-		std::getline(std::cin, temp);
-		//PrintSlotUI();
-	}
-	else if (_iErrors == 8)
+	ClearScreen();
+	SetRgb(EColour::COLOUR_RED_ON_BLACK);
+	if (_iErrors >= SECURITY_STERN_WARNING_ERRORS)
 	{
-		ClearScreen();
-		SetRgb(EColour::COLOUR_RED_ON_BLACK);
 		std::cout << "\n\n\n\tCasino Security take you aside and speak to you sternly for several minutes.\n\n";
 		std::cout << "\tYou have been warned previously.  Continued breaking of the rules will result in expulsion.\n\n";
-		std::cout << "\tPress Enter to continue, but behave yourself...";
-		std::getline(std::cin, temp);
-		//PrintSlotUI();
+		std::cout << "\tPress any key to continue, but behave yourself...";
 	}
-	else if (_iErrors == 10)
+	else
 	{
-		ExitSlots(EExitCode::TOO_MANY_BAD_INPUTS, _user);
+		std::cout << "\n\n\n\tCasino Security have been notified of disruption in the casino.\n\n";
+		std::cout << "\tA security guard approaches you and asks you politely to follow the directions.\n\n";
+		std::cout << "\tPress any key to continue.";
 	}
-	else
+	std::cout.flush();
+	WaitForKey();
+	return;
+}
+
+//picks up the player's session from the snapshot file, if the machine stopped while one was in progress
+bool RestorePlayerSession(SlotSession* _session)
+{
+	SessionSnapshotReader reader;
+	if (!reader.Open(PLAYER_SNAPSHOT_FILE) || reader.GetSessionCount() != 1)
 	{
-		return;
+		return false;
 	}
+	RestoreSessionRecord(reader.GetRecords()[0], _session);
+	GetProgressiveJackpot().RestorePool(reader.GetHeader()->JackpotHundredths, reader.GetHeader()->JackpotPoolsClaimed);
+	return true;
 }
 
-//returns a (pseudo)random number between user's chosen minimum and maximum values
-int GetRandomNumber(int _iMinRand, int _iMaxRand)
+//saves the player's session to the snapshot file, including which question it was asking.  This happens before
+//each question, and once a spin has been paid, before its reels are shown.  Auto play saves at each redraw instead.
+void SavePlayerSession(SlotSession* _session)
 {
-	return _iMinRand + rand() % ((_iMaxRand - _iMinRand) + 1);
+	SaveSessions(PLAYER_SNAPSHOT_FILE, _session, 1);
+	return;
 }
 
 //Clears console screen. Copied from Lecture Slides. I don't understand it, but it works.
@@ -872,17 +1021,3 @@ void ClearScreen()
 	FillConsoleOutputAttribute(hConsole, csbi.wAttributes, dwConSize, coordScreen, &cCharsWritten);
 	SetConsoleCursorPosition(hConsole, coordScreen);
 }
-
-//This function takes a string as input, uses std::isdigit to loop through the stringand check if any digits are not numbers.
-bool IsOnlyNumbers(const string& str)
-{
-	for (char const& c : str)
-	{
-		if (std::isdigit(c) == 0) return false;
-	}
-	return true;
-}
-//onlyNumbers is borrowed and adapted from :
-//https://www.delftstack.com/howto/cpp/how-to-determine-if-a-string-is-number-cpp/
-//Limitations: checks each character for 0 - 9, so doesn't recognise decimal point or - as numbers.
-//Therefore only works for positive whole numbers.
\ No newline at end of file
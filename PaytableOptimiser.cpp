@@ -0,0 +1,210 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : PaytableOptimiser.cpp
+Description : Multi-threaded search for paytables that hit a target return to player
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "PaytableOptimiser.h"
+#include "SystemHelpers.h"
+
+//works out the greatest common divisor, used to skip reel weights that are just a multiple of a smaller set
+static int GreatestCommonDivisor(int _iFirst, int _iSecond)
+{
+	while (_iSecond != 0)
+	{
+		int remainder = _iFirst % _iSecond;
+		_iFirst = _iSecond;
+		_iSecond = remainder;
+	}
+	return _iFirst;
+}
+
+//true if the first candidate is at least as good as the second on every goal, and better on at least one.
+//goals are: return closest to target, highest hit frequency, lowest variance.
+static bool DoesCandidateDominate(const PaytableCandidate& _first, const PaytableCandidate& _second)
+{
+	if (_first.ReturnError > _second.ReturnError
+		|| _first.Stats.HitFrequency < _second.Stats.HitFrequency
+		|| _first.Stats.Variance > _second.Stats.Variance)
+	{
+		return false;
+	}
+
+	return _first.ReturnError < _second.ReturnError
+		|| _first.Stats.HitFrequency > _second.Stats.HitFrequency
+		|| _first.Stats.Variance < _second.Stats.Variance;
+}
+
+//adds a candidate to a pareto set, unless something already in the set beats it.  Removes anything the new candidate beats.
+static void AddToParetoSet(std::vector<PaytableCandidate>& _paretoSet, const PaytableCandidate& _candidate)
+{
+	for (const PaytableCandidate& existing : _paretoSet)
+	{
+		if (DoesCandidateDominate(existing, _candidate)
+			|| (existing.ReturnError == _candidate.ReturnError
+				&& existing.Stats.HitFrequency == _candidate.Stats.HitFrequency
+				&& existing.Stats.Variance == _candidate.Stats.Variance)) //exact duplicate, keep the one we found first
+		{
+			return;
+		}
+	}
+
+	_paretoSet.erase(std::remove_if(_paretoSet.begin(), _paretoSet.end(),
+		[&_candidate](const PaytableCandidate& existing) { return DoesCandidateDominate(_candidate, existing); }),
+		_paretoSet.end());
+	_paretoSet.push_back(_candidate);
+}
+
+//builds every set of reel weights worth searching.
+//only the 7 is special, so the other five values are kept in ascending order of weight - any other order gives identical stats.
+//weights with a common factor (e.g. 2,2,2,2,2,2) are skipped as they are the same as a smaller set (1,1,1,1,1,1).
+static std::vector<SlotPaytable> BuildReelWeightSets(int _iMaxReelWeight)
+{
+	std::vector<SlotPaytable> weightSets;
+	int weights[REEL_SYMBOL_COUNT];
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		weights[i] = 1;
+	}
+
+	while (true)
+	{
+		bool ascending = true;
+		for (int i = 1; i < REEL_SYMBOL_COUNT - 1; ++i)
+		{
+			if (weights[i] < weights[i - 1])
+			{
+				ascending = false;
+				break;
+			}
+		}
+
+		int divisor = 0;
+		for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+		{
+			divisor = GreatestCommonDivisor(divisor, weights[i]);
+		}
+
+		if (ascending && divisor == 1)
+		{
+			SlotPaytable paytable;
+			for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+			{
+				paytable.ReelWeights[i] = weights[i];
+			}
+			weightSets.push_back(paytable);
+		}
+
+		//count up through every combination like an odometer
+		int digit = 0;
+		while (digit < REEL_SYMBOL_COUNT && weights[digit] == _iMaxReelWeight)
+		{
+			weights[digit] = 1;
+			digit++;
+		}
+		if (digit == REEL_SYMBOL_COUNT)
+		{
+			break;
+		}
+		weights[digit]++;
+	}
+
+	return weightSets;
+}
+
+//searches every multiplier and reel weight combination in the limits, scoring each one exactly with EvaluatePaytable.
+//threads take one set of reel weights at a time and try every multiplier against it, keeping their own pareto set
+//which are merged at the end.  A thread count of 0 uses every core.
+PaytableSearchReport OptimisePaytables(const PaytableSearchLimits& _limits, int _iThreadCount)
+{
+	PaytableSearchReport report;
+	auto startTime = std::chrono::steady_clock::now();
+
+	_iThreadCount = GetWorkerThreadCount(_iThreadCount);
+	report.ThreadsUsed = _iThreadCount;
+
+	std::vector<SlotPaytable> weightSets = BuildReelWeightSets(_limits.MaxReelWeight);
+	std::atomic<size_t> nextWeightSet(0);
+	std::vector<std::vector<PaytableCandidate>> threadParetoSets(_iThreadCount);
+	std::vector<long long> threadEvaluated(_iThreadCount, 0);
+
+	auto searchWorker = [&](int _iThreadIndex)
+	{
+		std::vector<PaytableCandidate>& paretoSet = threadParetoSets[_iThreadIndex];
+		long long evaluated = 0;
+
+		while (true)
+		{
+			size_t weightIndex = nextWeightSet.fetch_add(1);
+			if (weightIndex >= weightSets.size())
+			{
+				break;
+			}
+
+			PaytableCandidate candidate;
+			candidate.Paytable = weightSets[weightIndex];
+			ResultChances chances = GetResultChances(candidate.Paytable.ReelWeights);
+
+			for (int two = _limits.MinTwoMatch; two <= _limits.MaxTwoMatch; ++two)
+			{
+				candidate.Paytable.TwoMatchMultiplier = two;
+				for (int three = _limits.MinThreeMatch; three <= _limits.MaxThreeMatch; ++three)
+				{
+					candidate.Paytable.ThreeMatchMultiplier = three;
+					for (int jackpot = _limits.MinJackpot; jackpot <= _limits.MaxJackpot; ++jackpot)
+					{
+						candidate.Paytable.JackpotMultiplier = jackpot;
+						candidate.Stats = EvaluatePaytable(candidate.Paytable, chances);
+						evaluated++;
+
+						candidate.ReturnError = std::fabs(candidate.Stats.ReturnToPlayer - _limits.TargetReturnToPlayer);
+						if (candidate.ReturnError <= _limits.ReturnTolerance)
+						{
+							AddToParetoSet(paretoSet, candidate);
+						}
+					}
+				}
+			}
+		}
+
+		threadEvaluated[_iThreadIndex] = evaluated;
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < _iThreadCount; ++i)
+	{
+		workers.push_back(std::thread(searchWorker, i));
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	//merge each thread's pareto set into the final one
+	for (int i = 0; i < _iThreadCount; ++i)
+	{
+		report.CandidatesEvaluated += threadEvaluated[i];
+		for (const PaytableCandidate& candidate : threadParetoSets[i])
+		{
+			AddToParetoSet(report.ParetoSet, candidate);
+		}
+	}
+
+	std::sort(report.ParetoSet.begin(), report.ParetoSet.end(),
+		[](const PaytableCandidate& _first, const PaytableCandidate& _second) { return _first.Stats.HitFrequency > _second.Stats.HitFrequency; });
+
+	report.SecondsTaken = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return report;
+}
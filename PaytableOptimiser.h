@@ -0,0 +1,50 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : PaytableOptimiser.h
+Description : Multi-threaded search for paytables that hit a target return to player
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "SlotEngine.h"
+
+//ranges the optimiser searches over, plus the return it is aiming for
+struct PaytableSearchLimits
+{
+	double TargetReturnToPlayer = 0.95;
+	double ReturnTolerance = 0.005; //candidates further than this from the target are thrown away
+	int MinTwoMatch = 1;
+	int MaxTwoMatch = 5;
+	int MinThreeMatch = 2;
+	int MaxThreeMatch = 25;
+	int MinJackpot = 5;
+	int MaxJackpot = 200;
+	int MaxReelWeight = 6; //each reel value gets a weight from 1 to this
+};
+
+//a paytable the optimiser kept, along with its exact statistics
+struct PaytableCandidate
+{
+	SlotPaytable Paytable;
+	PaytableStats Stats;
+	double ReturnError = 0.0; //distance from the target return to player
+};
+
+//summary of an optimiser run
+struct PaytableSearchReport
+{
+	std::vector<PaytableCandidate> ParetoSet; //sorted by hit frequency, highest first
+	long long CandidatesEvaluated = 0;
+	double SecondsTaken = 0.0;
+	int ThreadsUsed = 0;
+};
+
+PaytableSearchReport OptimisePaytables(const PaytableSearchLimits& _limits, int _iThreadCount = 0);
@@ -0,0 +1,253 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : ProgressiveJackpot.cpp
+Description : Progressive jackpot pool that every session pays into, shared safely between threads
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ProgressiveJackpot.h"
+#include "SystemHelpers.h"
+
+//gives each thread its own shard the first time it contributes, handed out in turn so threads spread evenly
+static int GetThreadShard()
+{
+	static std::atomic<int> nextShard(0);
+	thread_local int shard = nextShard.fetch_add(1, std::memory_order_relaxed) % JACKPOT_SHARD_COUNT;
+	return shard;
+}
+
+ProgressiveJackpot::ProgressiveJackpot(long long _iSeedChips)
+{
+	static std::atomic<uint64_t> nextLedgerKey(1);
+	SeedHundredths = _iSeedChips * 100;
+	LedgerKey = nextLedgerKey.fetch_add(1, std::memory_order_relaxed);
+}
+
+//the calling thread's ledger for this jackpot.  Each jackpot has its own key, so a test jackpot never touches the
+//machine's figures, even one made later at the same address.  The last one used is kept to hand, as a thread
+//almost always works with the one jackpot.
+JackpotLedger& ProgressiveJackpot::GetThreadLedgerEntry() const
+{
+	thread_local std::unordered_map<uint64_t, JackpotLedger> ledgers;
+	thread_local uint64_t lastKey = 0;
+	thread_local JackpotLedger* pLastLedger = nullptr;
+	if (lastKey != LedgerKey)
+	{
+		pLastLedger = &ledgers[LedgerKey]; //map entries never move, so the pointer stays good
+		lastKey = LedgerKey;
+	}
+	return *pLastLedger;
+}
+
+//adds the jackpot's slice of a bet to the pool
+void ProgressiveJackpot::Contribute(int _iBet)
+{
+	long long hundredths = (long long)_iBet * JACKPOT_CONTRIBUTION_PERCENT;
+	Shards[GetThreadShard()].Hundredths.fetch_add(hundredths, std::memory_order_relaxed);
+	GetThreadLedgerEntry().PoolChangeHundredths += hundredths;
+}
+
+//pays out the whole pool to a winning bet and starts a new pool from the seed.
+//returns the whole chips won - any fraction of a chip is left in the pool for the next winner.
+//a bet below JACKPOT_QUALIFYING_BET wins nothing and leaves the pool alone.
+//if a pool number is asked for, it is set to which pool this was (1 for the first pool ever claimed, and so on), or 0 if none was won.
+//no more than _iMostChips are paid.  Anything over that goes straight back into the pool for the next winner, so a
+//winner who can only hold so much never loses the rest - it is still there to be won.
+long long ProgressiveJackpot::ClaimJackpot(int _iBet, long long* _pPoolNumber, long long _iMostChips)
+{
+	if (_pPoolNumber != nullptr)
+	{
+		*_pPoolNumber = 0;
+	}
+	if (_iBet < JACKPOT_QUALIFYING_BET)
+	{
+		return 0;
+	}
+
+	//sweep the shards into the total.  Another claim sweeping at the same time just moves some of it itself.
+	for (int i = 0; i < JACKPOT_SHARD_COUNT; ++i)
+	{
+		long long swept = Shards[i].Hundredths.exchange(0, std::memory_order_acq_rel);
+		if (swept != 0)
+		{
+			TotalHundredths.fetch_add(swept, std::memory_order_acq_rel);
+		}
+	}
+
+	//the claim itself - whatever this exchange takes, no other claim can have
+	long long wonHundredths = SeedHundredths + TotalHundredths.exchange(0, std::memory_order_acq_rel);
+	long long wonChips = wonHundredths / 100;
+	long long leftOver = wonHundredths % 100;
+	if (wonChips > _iMostChips)
+	{
+		leftOver += (wonChips - _iMostChips) * 100;
+		wonChips = _iMostChips;
+	}
+	if (leftOver != 0)
+	{
+		TotalHundredths.fetch_add(leftOver, std::memory_order_relaxed);
+	}
+
+	long long poolNumber = PoolsClaimed.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (_pPoolNumber != nullptr)
+	{
+		*_pPoolNumber = poolNumber;
+	}
+
+	//the pool went from seed plus what was taken, down to a new seed plus whatever was left over
+	JackpotLedger& ledger = GetThreadLedgerEntry();
+	ledger.PoolChangeHundredths += SeedHundredths - wonChips * 100;
+	ledger.PoolsClaimed++;
+	return wonChips;
+}
+
+//current size of the pool in hundredths of a chip, seed included.  Exact once nothing else is contributing or claiming,
+//otherwise a close enough figure for the display.
+long long ProgressiveJackpot::GetPoolHundredths() const
+{
+	long long total = SeedHundredths + TotalHundredths.load(std::memory_order_relaxed);
+	for (int i = 0; i < JACKPOT_SHARD_COUNT; ++i)
+	{
+		total += Shards[i].Hundredths.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+//current size of the pool in whole chips, for the display
+long long ProgressiveJackpot::GetPoolChips() const
+{
+	return GetPoolHundredths() / 100;
+}
+
+//how many pools have been won so far
+long long ProgressiveJackpot::GetPoolsClaimed() const
+{
+	return PoolsClaimed.load(std::memory_order_relaxed);
+}
+
+//sets the pool back to what was saved in a snapshot.  Only for use before play starts.
+void ProgressiveJackpot::RestorePool(long long _iPoolHundredths, long long _iPoolsClaimed)
+{
+	for (int i = 0; i < JACKPOT_SHARD_COUNT; ++i)
+	{
+		Shards[i].Hundredths.store(0, std::memory_order_relaxed);
+	}
+	TotalHundredths.store(_iPoolHundredths - SeedHundredths, std::memory_order_relaxed);
+	PoolsClaimed.store(_iPoolsClaimed, std::memory_order_relaxed);
+	return;
+}
+
+//the jackpot shared by every session on this machine
+ProgressiveJackpot& GetProgressiveJackpot()
+{
+	static ProgressiveJackpot jackpot;
+	return jackpot;
+}
+
+//what the calling thread has paid into and won from this jackpot so far
+JackpotLedger ProgressiveJackpot::GetThreadLedger() const
+{
+	return GetThreadLedgerEntry();
+}
+
+//has every thread bet and contribute as fast as it can, claiming the jackpot on roughly one bet in _iClaimOneIn,
+//then checks the books balance and that no pool was paid out twice
+JackpotStressReport RunJackpotStressTest(int _iThreadCount, long long _iBetsPerThread, int _iClaimOneIn)
+{
+	JackpotStressReport report;
+	ProgressiveJackpot jackpot;
+
+	_iThreadCount = GetWorkerThreadCount(_iThreadCount);
+	if (_iClaimOneIn <= 0)
+	{
+		_iClaimOneIn = 1;
+	}
+
+	std::vector<long long> contributedHundredths(_iThreadCount, 0);
+	std::vector<long long> wonChips(_iThreadCount, 0);
+	std::vector<std::vector<long long>> poolsWon(_iThreadCount);
+
+	auto stressWorker = [&](int _iThreadIndex)
+	{
+		//quick xorshift for bet sizes, the test only needs variety, not security
+		uint32_t state = 2463534242u + (uint32_t)_iThreadIndex * 7919u;
+		long long contributed = 0;
+		long long won = 0;
+		for (long long i = 0; i < _iBetsPerThread; ++i)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			int bet = 1 + (int)(state % 500);
+			jackpot.Contribute(bet);
+			contributed += (long long)bet * JACKPOT_CONTRIBUTION_PERCENT;
+
+			if ((state >> 16) % _iClaimOneIn == 0)
+			{
+				long long poolNumber = 0;
+				won += jackpot.ClaimJackpot(bet, &poolNumber);
+				if (poolNumber > 0) //bets under the qualifying bet don't win a pool
+				{
+					poolsWon[_iThreadIndex].push_back(poolNumber);
+				}
+			}
+		}
+		contributedHundredths[_iThreadIndex] = contributed;
+		wonChips[_iThreadIndex] = won;
+	};
+
+	auto startTime = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int i = 0; i < _iThreadCount; ++i)
+	{
+		workers.push_back(std::thread(stressWorker, i));
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	report.SecondsTaken = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	long long totalContributed = 0;
+	long long totalWon = 0;
+	std::vector<long long> allPools;
+	for (int i = 0; i < _iThreadCount; ++i)
+	{
+		totalContributed += contributedHundredths[i];
+		totalWon += wonChips[i];
+		allPools.insert(allPools.end(), poolsWon[i].begin(), poolsWon[i].end());
+	}
+	report.Contributions = _iBetsPerThread * _iThreadCount;
+	report.Claims = (long long)allPools.size();
+
+	//money in (bets and one seed per pool, including the one still running) must equal money out plus what's left
+	long long moneyIn = totalContributed + JACKPOT_SEED_CHIPS * 100 * (report.Claims + 1);
+	long long moneyOut = totalWon * 100 + jackpot.GetPoolHundredths();
+	report.NothingLost = moneyIn == moneyOut && jackpot.GetPoolsClaimed() == report.Claims;
+
+	std::sort(allPools.begin(), allPools.end());
+	report.OneWinnerPerPool = true;
+	for (size_t i = 0; i < allPools.size(); ++i)
+	{
+		if (allPools[i] != (long long)i + 1)
+		{
+			report.OneWinnerPerPool = false;
+			break;
+		}
+	}
+
+	return report;
+}
@@ -0,0 +1,80 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : ProgressiveJackpot.h
+Description : Progressive jackpot pool that every session pays into, shared safely between threads
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+const int JACKPOT_SHARD_COUNT = 64; //separate counters contributions are spread over, so threads don't fight over one
+const int JACKPOT_CONTRIBUTION_PERCENT = 2; //slice of every bet that goes into the pool
+const long long JACKPOT_SEED_CHIPS = 1000; //the house starts every new pool off with this much
+const int JACKPOT_QUALIFYING_BET = 100; //smallest bet that wins the pool on three 7s.  Smaller bets still pay into it.
+
+//what one thread has done to a pool: what it paid in, less what it won (with the seed each of its wins put back).
+//kept per thread and per jackpot so a session snapshot can take the pool's change along with the sessions that caused it.
+struct JackpotLedger
+{
+	long long PoolChangeHundredths = 0;
+	long long PoolsClaimed = 0;
+};
+
+//Progressive jackpot pool.  Amounts are kept in hundredths of a chip so a 2% slice of any bet is exact.
+//Contributing is a single atomic add to the calling thread's own shard, so sessions never wait on each other.
+//Claiming is lock free too: the claimer sweeps every shard into the pool total, then takes the total with one atomic
+//exchange.  Only one exchange can get any given chip, so two jackpots hit at the same time can't both be paid the
+//same pool: the first exchange takes it, and the second gets the next pool (the seed plus whatever has come in since).
+//A contribution that lands while a claim is in progress either makes it into this pool or stays for the next one,
+//it is never lost or counted twice.
+//Only a bet of JACKPOT_QUALIFYING_BET or more can claim the pool.  Without that, the seed alone would pay a 1 chip bet
+//far more than it staked.
+class ProgressiveJackpot
+{
+public:
+	explicit ProgressiveJackpot(long long _iSeedChips = JACKPOT_SEED_CHIPS);
+
+	void Contribute(int _iBet);
+	long long ClaimJackpot(int _iBet, long long* _pPoolNumber = nullptr, long long _iMostChips = LLONG_MAX);
+	long long GetPoolChips() const;
+	long long GetPoolHundredths() const;
+	long long GetPoolsClaimed() const;
+	void RestorePool(long long _iPoolHundredths, long long _iPoolsClaimed);
+	JackpotLedger GetThreadLedger() const;
+
+private:
+	struct alignas(64) JackpotShard
+	{
+		std::atomic<long long> Hundredths{ 0 };
+	};
+
+	JackpotLedger& GetThreadLedgerEntry() const;
+
+	JackpotShard Shards[JACKPOT_SHARD_COUNT];
+	alignas(64) std::atomic<long long> TotalHundredths{ 0 }; //swept out of the shards, and what a claim takes
+	std::atomic<long long> PoolsClaimed{ 0 };
+	long long SeedHundredths;
+	uint64_t LedgerKey; //tells this jackpot's entries in the per thread ledgers apart from any other jackpot's
+};
+
+//results of hammering a jackpot from many threads at once
+struct JackpotStressReport
+{
+	long long Contributions = 0;
+	long long Claims = 0;
+	double SecondsTaken = 0.0;
+	bool NothingLost = false; //every hundredth contributed was either paid out or is still in the pool
+	bool OneWinnerPerPool = false; //every pool number from 1 to Claims was won exactly once
+};
+
+ProgressiveJackpot& GetProgressiveJackpot();
+JackpotStressReport RunJackpotStressTest(int _iThreadCount, long long _iBetsPerThread, int _iClaimOneIn);
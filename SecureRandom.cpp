@@ -0,0 +1,288 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SecureRandom.cpp
+Description : ChaCha20 random number generator seeded from the operating system,
+              with a background thread that keeps a buffer of random numbers ready for the spin path
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <windows.h>
+#include <bcrypt.h>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "SecureRandom.h"
+#include "SystemHelpers.h"
+
+#pragma comment(lib, "bcrypt.lib")
+
+const int POOL_CAPACITY = 1 << 16; //words held ready in the ring buffer, must be a power of 2
+const int POOL_REFILL_WORDS = 16 * 64; //producer waits for this much free space, then generates 64 blocks in one go
+
+//ring buffer of random words.  One background thread fills it, any number of spin threads take from it.
+//Head and Tail only ever count up, and are padded onto separate cache lines so the two sides don't slow each other down.
+struct SecureRandomPool
+{
+	std::atomic<uint64_t> Head{ 0 }; //next slot the producer will write, only changed by the producer
+	char HeadPadding[64];
+	std::atomic<uint64_t> Tail{ 0 }; //next slot a consumer will take
+	char TailPadding[64];
+	std::atomic<bool> KeepRunning{ false };
+	std::atomic<long long> FallbackCount{ 0 }; //times the buffer was empty and a spin generated its own number
+	std::atomic<uint32_t> Words[POOL_CAPACITY];
+	std::thread Producer;
+};
+
+static SecureRandomPool* g_pPool = nullptr; //never deleted, so it is still safe to use while the program is exiting
+
+//rotates a 32 bit word left, used by the ChaCha20 quarter round
+static inline uint32_t RotateLeft(uint32_t _iValue, int _iBits)
+{
+	return (_iValue << _iBits) | (_iValue >> (32 - _iBits));
+}
+
+//ChaCha20 quarter round, mixes four words of the state together
+static inline void QuarterRound(uint32_t _state[16], int _a, int _b, int _c, int _d)
+{
+	_state[_a] += _state[_b]; _state[_d] = RotateLeft(_state[_d] ^ _state[_a], 16);
+	_state[_c] += _state[_d]; _state[_b] = RotateLeft(_state[_b] ^ _state[_c], 12);
+	_state[_a] += _state[_b]; _state[_d] = RotateLeft(_state[_d] ^ _state[_a], 8);
+	_state[_c] += _state[_d]; _state[_b] = RotateLeft(_state[_b] ^ _state[_c], 7);
+}
+
+//fills a buffer from the operating system's cryptographic random number source
+bool FillFromSystemEntropy(void* _pBuffer, unsigned long _iBytes)
+{
+	NTSTATUS status = BCryptGenRandom(NULL, (PUCHAR)_pBuffer, _iBytes, BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+	return BCRYPT_SUCCESS(status);
+}
+
+//seeds the generator with a fresh key and nonce from the operating system
+bool ChaCha20Generator::SeedFromSystem()
+{
+	uint32_t seed[11];
+	if (!FillFromSystemEntropy(seed, sizeof(seed)))
+	{
+		return false;
+	}
+	Seed(seed, seed + 8, 0);
+
+	//don't leave the key lying around on the stack
+	SecureZeroMemory(seed, sizeof(seed));
+	return true;
+}
+
+//sets up the state from a 256 bit key, 96 bit nonce and starting block counter
+void ChaCha20Generator::Seed(const uint32_t _key[8], const uint32_t _nonce[3], uint32_t _iCounter)
+{
+	State[0] = 0x61707865; //"expand 32-byte k"
+	State[1] = 0x3320646e;
+	State[2] = 0x79622d32;
+	State[3] = 0x6b206574;
+	for (int i = 0; i < 8; ++i)
+	{
+		State[4 + i] = _key[i];
+	}
+	State[12] = _iCounter;
+	State[13] = _nonce[0];
+	State[14] = _nonce[1];
+	State[15] = _nonce[2];
+
+	BlockPosition = 16;
+	return;
+}
+
+//generates the next 64 bytes of key stream and moves the block counter on
+void ChaCha20Generator::GenerateBlock(uint32_t _output[16])
+{
+	uint32_t working[16];
+	for (int i = 0; i < 16; ++i)
+	{
+		working[i] = State[i];
+	}
+
+	for (int round = 0; round < 10; ++round) //20 rounds, done as 10 pairs of column and diagonal rounds
+	{
+		QuarterRound(working, 0, 4, 8, 12);
+		QuarterRound(working, 1, 5, 9, 13);
+		QuarterRound(working, 2, 6, 10, 14);
+		QuarterRound(working, 3, 7, 11, 15);
+		QuarterRound(working, 0, 5, 10, 15);
+		QuarterRound(working, 1, 6, 11, 12);
+		QuarterRound(working, 2, 7, 8, 13);
+		QuarterRound(working, 3, 4, 9, 14);
+	}
+
+	for (int i = 0; i < 16; ++i)
+	{
+		_output[i] = working[i] + State[i];
+	}
+
+	//carry into the first nonce word so the stream never repeats, even after 2^32 blocks
+	State[12]++;
+	if (State[12] == 0)
+	{
+		State[13]++;
+	}
+	return;
+}
+
+//turns random words into a number between min and max with no modulo bias.
+//words below the threshold would make the low numbers slightly more likely, so they are thrown away and another is drawn.
+template <typename WordSource>
+static int GetUnbiasedNumberFrom(WordSource _getWord, int _iMinRand, int _iMaxRand)
+{
+	uint32_t range = (uint32_t)(_iMaxRand - _iMinRand) + 1;
+	uint32_t threshold = (0u - range) % range; //2^32 mod range
+	uint32_t word;
+	do
+	{
+		word = _getWord();
+	} while (word < threshold);
+
+	return _iMinRand + (int)(word % range);
+}
+
+//returns a random number between min and max from the given generator
+int GetUnbiasedNumber(ChaCha20Generator& _generator, int _iMinRand, int _iMaxRand)
+{
+	return GetUnbiasedNumberFrom([&_generator]() { return _generator.NextWord(); }, _iMinRand, _iMaxRand);
+}
+
+//background thread that keeps the ring buffer topped up
+static void RunPoolProducer(SecureRandomPool* _pPool, ChaCha20Generator _generator)
+{
+	uint32_t block[16];
+	while (_pPool->KeepRunning.load(std::memory_order_relaxed))
+	{
+		uint64_t head = _pPool->Head.load(std::memory_order_relaxed);
+		uint64_t tail = _pPool->Tail.load(std::memory_order_acquire);
+		if (POOL_CAPACITY - (head - tail) < (uint64_t)POOL_REFILL_WORDS)
+		{
+			Sleep(1); //buffer is nearly full, nothing to do yet
+			continue;
+		}
+
+		for (int i = 0; i < POOL_REFILL_WORDS; i += 16)
+		{
+			_generator.GenerateBlock(block);
+			for (int j = 0; j < 16; ++j)
+			{
+				_pPool->Words[(head + i + j) & (POOL_CAPACITY - 1)].store(block[j], std::memory_order_relaxed);
+			}
+		}
+		_pPool->Head.store(head + POOL_REFILL_WORDS, std::memory_order_release);
+	}
+	return;
+}
+
+//seeds a generator from the operating system and starts the background thread filling the buffer.
+//returns false if the operating system couldn't provide a seed, in which case the game must not run.
+bool StartSecureRandomPool()
+{
+	if (g_pPool != nullptr)
+	{
+		return true;
+	}
+
+	ChaCha20Generator generator;
+	if (!generator.SeedFromSystem())
+	{
+		return false;
+	}
+
+	g_pPool = new SecureRandomPool();
+	for (int i = 0; i < POOL_CAPACITY; ++i)
+	{
+		g_pPool->Words[i].store(0, std::memory_order_relaxed);
+	}
+	g_pPool->KeepRunning = true;
+	g_pPool->Producer = std::thread(RunPoolProducer, g_pPool, generator);
+
+	CleanUpAtExit(StopSecureRandomPool);
+	return true;
+}
+
+//stops the background thread.  Numbers can still be drawn afterwards, they are just generated on the spot.
+void StopSecureRandomPool()
+{
+	if (g_pPool != nullptr && g_pPool->KeepRunning)
+	{
+		g_pPool->KeepRunning = false;
+		g_pPool->Producer.join();
+	}
+	return;
+}
+
+//generates a word on the calling thread, used when the buffer is empty or hasn't been started.
+//each thread has its own generator so nothing is shared and nothing has to wait.
+static uint32_t GetFallbackWord()
+{
+	thread_local ChaCha20Generator generator;
+	thread_local bool isSeeded = false;
+	if (!isSeeded)
+	{
+		if (!generator.SeedFromSystem())
+		{
+			std::cout << "\n  The secure random number generator could not be seeded.  The machine is shutting down.\n";
+			exit(1);
+		}
+		isSeeded = true;
+	}
+
+	if (g_pPool != nullptr)
+	{
+		g_pPool->FallbackCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	return generator.NextWord();
+}
+
+//takes the next random word from the buffer.  Never waits - if the buffer is empty the word is generated on this thread instead.
+uint32_t GetSecureRandomWord()
+{
+	if (g_pPool == nullptr)
+	{
+		return GetFallbackWord();
+	}
+
+	uint64_t tail = g_pPool->Tail.load(std::memory_order_relaxed);
+	while (true)
+	{
+		uint64_t head = g_pPool->Head.load(std::memory_order_acquire);
+		if (tail == head)
+		{
+			return GetFallbackWord();
+		}
+
+		//read the word first, then claim it.  If another thread claimed it first the exchange fails, tail is
+		//updated to the latest value and we try again with the next word.
+		uint32_t word = g_pPool->Words[tail & (POOL_CAPACITY - 1)].load(std::memory_order_relaxed);
+		if (g_pPool->Tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			return word;
+		}
+	}
+}
+
+//returns a random number between min and max, drawn from the secure buffer
+int GetSecureRandomNumber(int _iMinRand, int _iMaxRand)
+{
+	return GetUnbiasedNumberFrom(GetSecureRandomWord, _iMinRand, _iMaxRand);
+}
+
+//how many words had to be generated on the spin path because the buffer was empty
+long long GetSecureRandomFallbackCount()
+{
+	if (g_pPool == nullptr)
+	{
+		return 0;
+	}
+	return g_pPool->FallbackCount.load(std::memory_order_relaxed);
+}
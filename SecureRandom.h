@@ -0,0 +1,50 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SecureRandom.h
+Description : ChaCha20 random number generator seeded from the operating system,
+              with a background thread that keeps a buffer of random numbers ready for the spin path
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+//ChaCha20 stream cipher used as a random number generator (RFC 8439 block function)
+class ChaCha20Generator
+{
+public:
+	bool SeedFromSystem();
+	void Seed(const uint32_t _key[8], const uint32_t _nonce[3], uint32_t _iCounter = 0);
+	void GenerateBlock(uint32_t _output[16]);
+
+	//gives back the next random word, generating a new block when the last one is used up
+	uint32_t NextWord()
+	{
+		if (BlockPosition == 16)
+		{
+			GenerateBlock(Block);
+			BlockPosition = 0;
+		}
+		return Block[BlockPosition++];
+	}
+
+private:
+	uint32_t State[16] = { 0 }; //constants, key, block counter and nonce
+	uint32_t Block[16] = { 0 }; //most recently generated block of output
+	int BlockPosition = 16; //next unused word in Block, 16 means it is used up
+};
+
+bool FillFromSystemEntropy(void* _pBuffer, unsigned long _iBytes);
+int GetUnbiasedNumber(ChaCha20Generator& _generator, int _iMinRand, int _iMaxRand);
+
+bool StartSecureRandomPool();
+void StopSecureRandomPool();
+uint32_t GetSecureRandomWord();
+int GetSecureRandomNumber(int _iMinRand, int _iMaxRand);
+long long GetSecureRandomFallbackCount();
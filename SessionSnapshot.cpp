@@ -0,0 +1,323 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SessionSnapshot.cpp
+Description : Saves every live session to a snapshot file while play carries on, and brings them back after a restart
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <windows.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+#include "SessionSnapshot.h"
+#include "ProgressiveJackpot.h"
+
+//quick checksum over the records, 8 bytes at a time, to catch a file that was cut short or damaged
+static uint64_t GetRecordChecksum(const SessionRecord* _pRecords, uint64_t _iCount)
+{
+	const uint8_t* bytes = (const uint8_t*)_pRecords;
+	uint64_t byteCount = _iCount * sizeof(SessionRecord);
+	uint64_t checksum = 14695981039346656037ull;
+	uint64_t i = 0;
+	for (; i + 8 <= byteCount; i += 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes + i, sizeof(word));
+		checksum = (checksum ^ word) * 1099511628211ull;
+	}
+	for (; i < byteCount; ++i)
+	{
+		checksum = (checksum ^ bytes[i]) * 1099511628211ull;
+	}
+	return checksum;
+}
+
+//auto play's settings aren't kept in a record, so a session asking the auto play questions or part way through a run
+//is saved as back at the menu - or as asking to buy more, if the run left it with no chips
+static ESessionState GetStateToSave(ESessionState _eState, int _iChips)
+{
+	if (_eState >= ESessionState::AWAITING_AUTO_SPIN_COUNT && _eState <= ESessionState::AUTO_PLAYING)
+	{
+		return _iChips > 0 ? ESessionState::AT_MENU : ESessionState::AWAITING_TOP_UP_CHOICE;
+	}
+	return _eState;
+}
+
+//copies the parts of a session worth keeping into a record
+SessionRecord MakeSessionRecord(SlotSession* _session)
+{
+	SessionRecord record = {};
+	SlotMachineUser& user = _session->User;
+	record.Chips = user.GetChips();
+	record.CumulativeMoney = user.GetCumulativeMoney();
+	record.SpinCount = _session->SpinCount;
+	record.InputErrors = (uint16_t)user.GetErrors();
+	record.State = (uint8_t)GetStateToSave(_session->State, user.GetChips());
+	record.ResumeState = (uint8_t)GetStateToSave(_session->ResumeState, user.GetChips());
+	for (int i = 0; i < REEL_COUNT; ++i)
+	{
+		record.LastSpin[i] = (uint8_t)user.LastSpin[i];
+	}
+	return record;
+}
+
+//puts a session back the way it was when the record was made
+void RestoreSessionRecord(const SessionRecord& _record, SlotSession* _session)
+{
+	SlotMachineUser& user = _session->User;
+	user.RestoreSavedState(_record.Chips, _record.CumulativeMoney, _record.InputErrors);
+	for (int i = 0; i < REEL_COUNT; ++i)
+	{
+		user.LastSpin[i] = _record.LastSpin[i];
+	}
+	_session->State = (ESessionState)_record.State;
+	_session->ResumeState = (ESessionState)_record.ResumeState;
+	_session->SpinCount = _record.SpinCount;
+	return;
+}
+
+//writes the records to a new file alongside the old snapshot, then swaps it in,
+//so a crash part way through writing still leaves the last good snapshot in place
+bool WriteSessionSnapshot(const std::string& _strFileName, const SessionRecord* _pRecords, uint64_t _iCount, uint64_t _iSnapshotNumber,
+	long long _iJackpotHundredths, long long _iJackpotPoolsClaimed)
+{
+	SessionSnapshotHeader header = {};
+	std::memcpy(header.Magic, "SLOTSNAP", sizeof(header.Magic));
+	header.Version = SESSION_SNAPSHOT_VERSION;
+	header.RecordSize = sizeof(SessionRecord);
+	header.SessionCount = _iCount;
+	header.SnapshotNumber = _iSnapshotNumber;
+	header.JackpotHundredths = _iJackpotHundredths;
+	header.JackpotPoolsClaimed = _iJackpotPoolsClaimed;
+	header.Checksum = GetRecordChecksum(_pRecords, _iCount);
+
+	std::string tempFileName = _strFileName + ".tmp";
+	{
+		std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)_pRecords, (std::streamsize)(_iCount * sizeof(SessionRecord)));
+		if (!file.good())
+		{
+			return false;
+		}
+	}
+	return MoveFileExA(tempFileName.c_str(), _strFileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+//snapshots a handful of sessions straight away, for when nothing else is changing them or the jackpot (e.g. the console game)
+bool SaveSessions(const std::string& _strFileName, SlotSession* _pSessions, uint64_t _iCount)
+{
+	std::vector<SessionRecord> records((size_t)_iCount);
+	for (uint64_t i = 0; i < _iCount; ++i)
+	{
+		records[(size_t)i] = MakeSessionRecord(&_pSessions[i]);
+	}
+	ProgressiveJackpot& jackpot = GetProgressiveJackpot();
+	return WriteSessionSnapshot(_strFileName, records.data(), _iCount, 1, jackpot.GetPoolHundredths(), jackpot.GetPoolsClaimed());
+}
+
+SessionSnapshotReader::~SessionSnapshotReader()
+{
+	Close();
+}
+
+//maps the whole file into memory and checks the header, size and checksum
+bool SessionSnapshotReader::Open(const std::string& _strFileName)
+{
+	Close();
+
+	if (!File.Open(_strFileName, sizeof(SessionSnapshotHeader)))
+	{
+		return false;
+	}
+
+	Header = (const SessionSnapshotHeader*)File.GetData();
+	Records = (const SessionRecord*)(File.GetData() + sizeof(SessionSnapshotHeader));
+	uint64_t recordBytes = File.GetSize() - sizeof(SessionSnapshotHeader);
+	if (std::memcmp(Header->Magic, "SLOTSNAP", sizeof(Header->Magic)) != 0 || Header->Version != SESSION_SNAPSHOT_VERSION
+		|| Header->RecordSize != sizeof(SessionRecord) || recordBytes != Header->SessionCount * sizeof(SessionRecord)
+		|| GetRecordChecksum(Records, Header->SessionCount) != Header->Checksum)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+//unmaps the file
+void SessionSnapshotReader::Close()
+{
+	File.Close();
+	Header = nullptr;
+	Records = nullptr;
+	return;
+}
+
+SessionSnapshotter::~SessionSnapshotter()
+{
+	if (SnapshotThread.joinable())
+	{
+		Stop();
+	}
+}
+
+//takes a first full copy of every session, then starts snapshotting every interval.
+//call before the workers start; the sessions must stay where they are until Stop.
+bool SessionSnapshotter::Start(const std::string& _strFileName, SlotSession* _pSessions, uint64_t _iSessionCount, int _iWorkerCount, double _dIntervalSeconds)
+{
+	FileName = _strFileName;
+	Sessions = _pSessions;
+	SessionCount = _iSessionCount;
+	WorkerCount = _iWorkerCount;
+	IntervalSeconds = _dIntervalSeconds > 0.0 ? _dIntervalSeconds : 1.0;
+	Stats = SessionSnapshotStats();
+	IsStopping = false;
+
+	Image.resize((size_t)SessionCount);
+	for (uint64_t i = 0; i < SessionCount; ++i)
+	{
+		Image[(size_t)i] = MakeSessionRecord(&Sessions[i]);
+	}
+	IsDirty.assign((size_t)SessionCount, 0);
+	Workers.reset(new SnapshotWorker[WorkerCount]);
+	JackpotHundredthsAtStart = GetProgressiveJackpot().GetPoolHundredths();
+	JackpotPoolsClaimedAtStart = GetProgressiveJackpot().GetPoolsClaimed();
+
+	//the first snapshot is the full copy just made, the workers have nothing to hand over for it yet
+	for (int i = 0; i < WorkerCount; ++i)
+	{
+		Workers[i].CollectedSnapshot.store(1, std::memory_order_relaxed);
+	}
+	RequestedSnapshot.store(1, std::memory_order_relaxed);
+	if (!WriteImage(1))
+	{
+		return false;
+	}
+	SnapshotThread = std::thread(&SessionSnapshotter::RunSnapshotThread, this);
+	return true;
+}
+
+//stops the snapshot thread and writes one last snapshot.  Call once every worker has called FinishWorker.
+SessionSnapshotStats SessionSnapshotter::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(StopMutex);
+		IsStopping = true;
+	}
+	StopSignal.notify_all();
+	if (SnapshotThread.joinable())
+	{
+		SnapshotThread.join();
+	}
+	TakeSnapshot();
+
+	for (int i = 0; i < WorkerCount; ++i)
+	{
+		double pause = Workers[i].LongestPauseNs / 1000.0;
+		if (pause > Stats.LongestPauseMicroseconds)
+		{
+			Stats.LongestPauseMicroseconds = pause;
+		}
+		Stats.RecordsCollected += Workers[i].RecordsCollected;
+	}
+	return Stats;
+}
+
+//called on a worker's own thread before it plays, so only the jackpot changes it makes from here on are counted
+void SessionSnapshotter::StartWorker(int _iWorker)
+{
+	Workers[_iWorker].LedgerAtStart = GetProgressiveJackpot().GetThreadLedger();
+	Workers[_iWorker].CollectedLedger = Workers[_iWorker].LedgerAtStart;
+	return;
+}
+
+//called by a worker as it finishes.  Hands over its last dirty sessions and tells the snapshotter not to wait for it again.
+void SessionSnapshotter::FinishWorker(int _iWorker)
+{
+	CollectDirtySessions(_iWorker);
+	Workers[_iWorker].CollectedSnapshot.store(UINT64_MAX, std::memory_order_release);
+	return;
+}
+
+//copies a worker's dirty sessions into the image, then lets the snapshot thread know this worker is done
+void SessionSnapshotter::CollectDirtySessions(int _iWorker)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	SnapshotWorker& worker = Workers[_iWorker];
+	uint64_t requested = RequestedSnapshot.load(std::memory_order_acquire);
+
+	for (uint64_t session : worker.DirtySessions)
+	{
+		Image[(size_t)session] = MakeSessionRecord(&Sessions[session]);
+		IsDirty[(size_t)session] = 0;
+	}
+	worker.RecordsCollected += (long long)worker.DirtySessions.size();
+	worker.DirtySessions.clear();
+	worker.CollectedLedger = GetProgressiveJackpot().GetThreadLedger(); //the jackpot as these sessions left it
+	worker.CollectedSnapshot.store(requested, std::memory_order_release);
+
+	long long pauseNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+	if (pauseNs > worker.LongestPauseNs)
+	{
+		worker.LongestPauseNs = pauseNs;
+	}
+	return;
+}
+
+//asks every worker for its dirty sessions, waits for them all to check in, then writes the image out.
+//workers carry on playing while the file is written, and won't touch the image again until the next snapshot is asked for.
+bool SessionSnapshotter::TakeSnapshot()
+{
+	uint64_t snapshotNumber = RequestedSnapshot.load(std::memory_order_relaxed) + 1;
+	RequestedSnapshot.store(snapshotNumber, std::memory_order_release);
+	for (int i = 0; i < WorkerCount; ++i)
+	{
+		while (Workers[i].CollectedSnapshot.load(std::memory_order_acquire) < snapshotNumber)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	return WriteImage(snapshotNumber);
+}
+
+//writes the image out, with the jackpot pool that goes with it, and keeps track of how long it took
+bool SessionSnapshotter::WriteImage(uint64_t _iSnapshotNumber)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	long long jackpotHundredths = JackpotHundredthsAtStart;
+	long long jackpotPoolsClaimed = JackpotPoolsClaimedAtStart;
+	for (int i = 0; i < WorkerCount; ++i)
+	{
+		jackpotHundredths += Workers[i].CollectedLedger.PoolChangeHundredths - Workers[i].LedgerAtStart.PoolChangeHundredths;
+		jackpotPoolsClaimed += Workers[i].CollectedLedger.PoolsClaimed - Workers[i].LedgerAtStart.PoolsClaimed;
+	}
+	bool written = WriteSessionSnapshot(FileName, Image.data(), SessionCount, _iSnapshotNumber, jackpotHundredths, jackpotPoolsClaimed);
+	Stats.LastWriteSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	Stats.SnapshotsWritten++;
+	Stats.AllWritten = Stats.AllWritten && written;
+	return written;
+}
+
+//takes a snapshot every interval until told to stop
+void SessionSnapshotter::RunSnapshotThread()
+{
+	std::unique_lock<std::mutex> lock(StopMutex);
+	while (!IsStopping)
+	{
+		StopSignal.wait_for(lock, std::chrono::microseconds((long long)(IntervalSeconds * 1e6)));
+		if (!IsStopping)
+		{
+			lock.unlock();
+			TakeSnapshot();
+			lock.lock();
+		}
+	}
+	return;
+}
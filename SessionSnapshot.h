@@ -0,0 +1,172 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SessionSnapshot.h
+Description : Saves every live session to a snapshot file while play carries on, and brings them back after a restart
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SlotSession.h"
+#include "ProgressiveJackpot.h"
+#include "SystemHelpers.h"
+
+//File layout (all numbers little endian):
+//  file header - "SLOTSNAP", version, record size, session count, snapshot number, jackpot pool, checksum of the records
+//  then one fixed size record per session, in the same order the sessions were given
+//Records are fixed size so a restore can index straight into the mapped file.  The last input and output lines
+//are only there to tidy up the screen, so they aren't saved.
+
+const uint32_t SESSION_SNAPSHOT_VERSION = 1;
+
+#pragma pack(push, 1)
+struct SessionSnapshotHeader
+{
+	char Magic[8]; //"SLOTSNAP"
+	uint32_t Version;
+	uint32_t RecordSize; //sizeof(SessionRecord) when written, so a file from a different layout is turned away
+	uint64_t SessionCount;
+	uint64_t SnapshotNumber; //counts up with every snapshot written by the same run
+	int64_t JackpotHundredths; //progressive jackpot pool, seed included
+	int64_t JackpotPoolsClaimed;
+	uint64_t Checksum; //of the records only
+};
+
+struct SessionRecord
+{
+	int32_t Chips;
+	int32_t CumulativeMoney;
+	int64_t SpinCount;
+	uint16_t InputErrors;
+	uint8_t State; //ESessionState, with auto play saved as back at the menu
+	uint8_t ResumeState; //ESessionState
+	uint8_t LastSpin[3];
+	uint8_t Reserved;
+};
+#pragma pack(pop)
+
+SessionRecord MakeSessionRecord(SlotSession* _session);
+void RestoreSessionRecord(const SessionRecord& _record, SlotSession* _session);
+bool WriteSessionSnapshot(const std::string& _strFileName, const SessionRecord* _pRecords, uint64_t _iCount, uint64_t _iSnapshotNumber,
+	long long _iJackpotHundredths, long long _iJackpotPoolsClaimed);
+bool SaveSessions(const std::string& _strFileName, SlotSession* _pSessions, uint64_t _iCount);
+
+//reads a snapshot by memory mapping it, so records are only touched as they are restored
+class SessionSnapshotReader
+{
+public:
+	~SessionSnapshotReader();
+
+	bool Open(const std::string& _strFileName);
+	void Close();
+
+	uint64_t GetSessionCount() const { return Header ? Header->SessionCount : 0; }
+	const SessionSnapshotHeader* GetHeader() const { return Header; }
+	const SessionRecord* GetRecords() const { return Records; }
+
+private:
+	MappedFile File;
+	const SessionSnapshotHeader* Header = nullptr;
+	const SessionRecord* Records = nullptr;
+};
+
+//how the snapshots taken while sessions were running went
+struct SessionSnapshotStats
+{
+	long long SnapshotsWritten = 0;
+	long long RecordsCollected = 0; //dirty sessions copied by the workers, over every snapshot
+	double LastWriteSeconds = 0.0;
+	double LongestPauseMicroseconds = 0.0; //longest any one worker stopped to hand over its dirty sessions
+	bool AllWritten = true;
+};
+
+//Takes snapshots of sessions that are being played on several worker threads, without stopping play.
+//The snapshotter keeps its own copy of every session's record.  A worker marks a session dirty whenever it changes it,
+//and when a snapshot is asked for, each worker copies just its dirty sessions into that copy the next time it checks in
+//between actions, then carries on.  Once every worker has checked in the copy is written out on the snapshotter's
+//own thread, so the only pause a worker sees is copying the sessions it changed since the last snapshot.
+//Each session is only ever changed by the one worker, and only checked in between actions, so every record saved
+//is a whole action's worth - never half way through a bet.
+//The jackpot pool is handed over the same way.  Each worker passes on its thread's JackpotLedger with its sessions, and
+//the pool saved is the pool at Start plus every worker's change, so it always matches the sessions saved with it -
+//a jackpot won after a worker checked in is in neither the winner's record nor the pool's change.
+class SessionSnapshotter
+{
+public:
+	~SessionSnapshotter();
+
+	bool Start(const std::string& _strFileName, SlotSession* _pSessions, uint64_t _iSessionCount, int _iWorkerCount, double _dIntervalSeconds);
+	SessionSnapshotStats Stop();
+
+	//called by a worker after it changes a session
+	void MarkDirty(int _iWorker, uint64_t _iSession)
+	{
+		if (!IsDirty[_iSession])
+		{
+			IsDirty[_iSession] = 1;
+			Workers[_iWorker].DirtySessions.push_back(_iSession);
+		}
+	}
+
+	//called by a worker between actions.  Normally just one atomic load.
+	void CheckIn(int _iWorker)
+	{
+		if (RequestedSnapshot.load(std::memory_order_acquire) != Workers[_iWorker].CollectedSnapshot.load(std::memory_order_relaxed))
+		{
+			CollectDirtySessions(_iWorker);
+		}
+	}
+
+	void StartWorker(int _iWorker);
+	void FinishWorker(int _iWorker);
+
+private:
+	struct SnapshotWorker
+	{
+		std::vector<uint64_t> DirtySessions;
+		std::atomic<uint64_t> CollectedSnapshot{ 0 };
+		JackpotLedger LedgerAtStart; //the worker thread's jackpot ledger before it played
+		JackpotLedger CollectedLedger; //and when it last handed its sessions over
+		long long LongestPauseNs = 0;
+		long long RecordsCollected = 0;
+		char Padding[64]; //keeps each worker's counters off its neighbour's cache line
+	};
+
+	void CollectDirtySessions(int _iWorker);
+	bool TakeSnapshot();
+	bool WriteImage(uint64_t _iSnapshotNumber);
+	void RunSnapshotThread();
+
+	std::string FileName;
+	SlotSession* Sessions = nullptr;
+	uint64_t SessionCount = 0;
+	int WorkerCount = 0;
+	double IntervalSeconds = 1.0;
+
+	std::vector<SessionRecord> Image; //the snapshot as it will be written
+	long long JackpotHundredthsAtStart = 0;
+	long long JackpotPoolsClaimedAtStart = 0;
+	std::vector<uint8_t> IsDirty; //one flag per session, each only touched by the worker that owns the session
+	std::unique_ptr<SnapshotWorker[]> Workers;
+	std::atomic<uint64_t> RequestedSnapshot{ 0 };
+
+	std::thread SnapshotThread;
+	std::mutex StopMutex;
+	std::condition_variable StopSignal;
+	bool IsStopping = false;
+	SessionSnapshotStats Stats;
+};
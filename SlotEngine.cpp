@@ -0,0 +1,164 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SlotEngine.cpp
+Description : Slot machine rules - result codes, paytables and exact paytable evaluation
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include "SlotEngine.h"
+#include "SecureRandom.h"
+
+//adds up the reel weights, which is the range a reel's draw is picked from
+static int GetTotalReelWeight(const SlotPaytable& _paytable)
+{
+	int totalWeight = 0;
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		totalWeight += _paytable.ReelWeights[i];
+	}
+	return totalWeight;
+}
+
+//finds the reel value a draw from 1 to the total weight lands on
+static int GetWeightedReelValue(const SlotPaytable& _paytable, int _iPick)
+{
+	int pick = _iPick;
+	for (int i = 0; i < REEL_SYMBOL_COUNT - 1; ++i)
+	{
+		pick -= _paytable.ReelWeights[i];
+		if (pick <= 0)
+		{
+			return REEL_MIN_VALUE + i;
+		}
+	}
+	return REEL_MAX_VALUE;
+}
+
+//spins one reel, with each value landing as often as its weight in the paytable says
+int SpinReel(const SlotPaytable& _paytable)
+{
+	return GetWeightedReelValue(_paytable, GetSecureRandomNumber(1, GetTotalReelWeight(_paytable)));
+}
+
+//same as above, but draws from the given generator instead of the shared buffer, for testing the generator on its own
+int SpinReel(const SlotPaytable& _paytable, ChaCha20Generator& _generator)
+{
+	return GetWeightedReelValue(_paytable, GetUnbiasedNumber(_generator, 1, GetTotalReelWeight(_paytable)));
+}
+
+//spins all three reels at once with nothing printed, for the simulator and anything else that doesn't need the display
+ESpinResultCode SpinReels(const SlotPaytable& _paytable, int _iSlotNums[REEL_COUNT])
+{
+	for (int i = 0; i < REEL_COUNT; ++i)
+	{
+		_iSlotNums[i] = SpinReel(_paytable);
+	}
+	return GetSpinResultCode(_iSlotNums);
+}
+
+//checks the three reel values to see if the spin is a winner or not
+ESpinResultCode GetSpinResultCode(const int _iSlotNums[REEL_COUNT])
+{
+	if ((_iSlotNums[0] == _iSlotNums[1]) && (_iSlotNums[1] == _iSlotNums[2]))
+	{
+		if (_iSlotNums[1] == REEL_MAX_VALUE)
+		{
+			return JACKPOT_THREE_SEVENS;
+		}
+		else
+		{
+			return THREE_NUMS_MATCH;
+		}
+	}
+	else if ((_iSlotNums[0] == _iSlotNums[1]) || (_iSlotNums[0] == _iSlotNums[2]) || (_iSlotNums[1] == _iSlotNums[2]))
+	{
+		return TWO_NUMS_MATCH;
+	}
+	else
+	{
+		return LOSING_SPIN;
+	}
+}
+
+//looks up how many times the bet a result code pays under the given paytable
+int GetPayoutMultiplier(const SlotPaytable& _paytable, ESpinResultCode _eResult)
+{
+	switch (_eResult)
+	{
+	case TWO_NUMS_MATCH:
+		return _paytable.TwoMatchMultiplier;
+	case THREE_NUMS_MATCH:
+		return _paytable.ThreeMatchMultiplier;
+	case JACKPOT_THREE_SEVENS:
+		return _paytable.JackpotMultiplier;
+	default: //losing spin, or anything unexpected, pays nothing
+		return 0;
+	}
+}
+
+//works out the chance of each paying result for a set of reel weights.
+//every reel is independent with the same weights, so the sum over all 6x6x6 outcomes collapses to a sum over the 6 values:
+//  P(triple of v) = p(v)^3, and P(exactly two of v) = 3 * p(v)^2 * (1 - p(v))
+ResultChances GetResultChances(const int _iReelWeights[REEL_SYMBOL_COUNT])
+{
+	ResultChances chances;
+
+	int totalWeight = 0;
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		totalWeight += _iReelWeights[i];
+	}
+	if (totalWeight <= 0) //no value can land, so nothing can pay
+	{
+		return chances;
+	}
+
+	for (int i = 0; i < REEL_SYMBOL_COUNT; ++i)
+	{
+		double p = (double)_iReelWeights[i] / totalWeight;
+		double triple = p * p * p;
+
+		chances.TwoMatch += 3.0 * p * p * (1.0 - p);
+		if (i + REEL_MIN_VALUE == REEL_MAX_VALUE)
+		{
+			chances.Jackpot += triple;
+		}
+		else
+		{
+			chances.ThreeMatch += triple;
+		}
+	}
+
+	return chances;
+}
+
+//works out the exact return, hit frequency and variance of a paytable without simulating any spins.
+//the progressive jackpot is left out, so the real return for a qualifying bet is higher than this.
+PaytableStats EvaluatePaytable(const SlotPaytable& _paytable)
+{
+	return EvaluatePaytable(_paytable, GetResultChances(_paytable.ReelWeights));
+}
+
+//same as above, but reuses result chances already worked out for the paytable's reel weights
+PaytableStats EvaluatePaytable(const SlotPaytable& _paytable, const ResultChances& _chances)
+{
+	PaytableStats stats;
+
+	double two = _paytable.TwoMatchMultiplier;
+	double three = _paytable.ThreeMatchMultiplier;
+	double jackpot = _paytable.JackpotMultiplier;
+
+	double meanPayout = _chances.TwoMatch * two + _chances.ThreeMatch * three + _chances.Jackpot * jackpot;
+	double meanSquarePayout = _chances.TwoMatch * two * two + _chances.ThreeMatch * three * three + _chances.Jackpot * jackpot * jackpot;
+
+	stats.ReturnToPlayer = meanPayout;
+	stats.Variance = meanSquarePayout - meanPayout * meanPayout;
+	stats.HitFrequency = (two > 0 ? _chances.TwoMatch : 0.0) + (three > 0 ? _chances.ThreeMatch : 0.0) + (jackpot > 0 ? _chances.Jackpot : 0.0);
+
+	return stats;
+}
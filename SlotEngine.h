@@ -0,0 +1,66 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SlotEngine.h
+Description : Slot machine rules - result codes, paytables and exact paytable evaluation
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+class ChaCha20Generator;
+
+//Constant definitions
+//what a spin landed.  The values are the original game's multipliers, which are now only the paytable's defaults -
+//what each result pays comes from the paytable in use, see GetPayoutMultiplier.
+enum ESpinResultCode
+{
+	LOSING_SPIN = 0, //no numbers match
+	TWO_NUMS_MATCH = 3, //two numbers match
+	THREE_NUMS_MATCH = 5, //triple but not 7s
+	JACKPOT_THREE_SEVENS = 10, //triple 7s
+};
+
+const int REEL_COUNT = 3; //number of reels on the machine
+const int REEL_MIN_VALUE = 2; //lowest number that can land on a reel
+const int REEL_MAX_VALUE = 7; //highest number that can land on a reel, also the jackpot number
+const int REEL_SYMBOL_COUNT = REEL_MAX_VALUE - REEL_MIN_VALUE + 1;
+
+//holds the multipliers and reel weights that decide what a spin pays.  Defaults match the original fixed game.
+struct SlotPaytable
+{
+	int TwoMatchMultiplier = TWO_NUMS_MATCH;
+	int ThreeMatchMultiplier = THREE_NUMS_MATCH;
+	int JackpotMultiplier = JACKPOT_THREE_SEVENS;
+	int ReelWeights[REEL_SYMBOL_COUNT] = { 1,1,1,1,1,1 }; //relative chance of each value 2-7 landing, same for every reel
+};
+
+//exact statistics for a paytable, all per 1 chip bet.  They cover the paytable's multipliers only - the progressive jackpot
+//is paid on top, and isn't counted, as what it adds depends on the bet and how big the pool has grown.
+struct PaytableStats
+{
+	double ReturnToPlayer = 0.0; //expected amount paid back per chip bet, not counting the progressive jackpot
+	double HitFrequency = 0.0; //chance that a spin pays anything
+	double Variance = 0.0; //variance of the amount paid back per chip bet
+};
+
+//chance of each paying result for a set of reel weights, shared by every candidate that uses the same weights
+struct ResultChances
+{
+	double TwoMatch = 0.0;
+	double ThreeMatch = 0.0;
+	double Jackpot = 0.0;
+};
+
+int SpinReel(const SlotPaytable& _paytable);
+int SpinReel(const SlotPaytable& _paytable, ChaCha20Generator& _generator);
+ESpinResultCode SpinReels(const SlotPaytable& _paytable, int _iSlotNums[REEL_COUNT]);
+ESpinResultCode GetSpinResultCode(const int _iSlotNums[REEL_COUNT]);
+int GetPayoutMultiplier(const SlotPaytable& _paytable, ESpinResultCode _eResult);
+ResultChances GetResultChances(const int _iReelWeights[REEL_SYMBOL_COUNT]);
+PaytableStats EvaluatePaytable(const SlotPaytable& _paytable);
+PaytableStats EvaluatePaytable(const SlotPaytable& _paytable, const ResultChances& _chances);
@@ -0,0 +1,96 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SlotMachineUser.h
+Description : Holds everything about one player's session at the slot machine
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <string>
+
+using std::string;
+
+//This class is to hold various variables relating to the user, to avoid using global variables
+class SlotMachineUser
+{
+public:
+	int LastSpin[3] = { 0,0,0 }; //stores the last spin values, for reprinting and keeping UI tidy
+
+	void SetOutput(string _newOutput)
+	{
+		LastOutput = _newOutput;
+	}
+
+	string GetOutput()
+	{
+		return LastOutput;
+	}
+
+	void SetInput(string _newInput)
+	{
+		LastInput = _newInput;
+	}
+
+	string GetInput()
+	{
+		return LastInput;
+	}
+
+	void AddError()
+	{
+		CumulativeInputErrors++;
+	}
+
+	int GetErrors()
+	{
+		return CumulativeInputErrors;
+	}
+
+	void AddChips(int _iChipsToAdd)
+	{
+		CurrentChips += _iChipsToAdd;
+	}
+
+	int GetChips()
+	{
+		return CurrentChips;
+	}
+
+	//negative value to cash out, positive value to buy more
+	void CashInOrOut(int _iAmountChanged)
+	{
+		CurrentChips += _iAmountChanged;
+		CumulativeMoney -= _iAmountChanged;
+	}
+
+	int GetFinancialPosition()
+	{
+		return CumulativeMoney + CurrentChips;
+	}
+
+	int GetCumulativeMoney()
+	{
+		return CumulativeMoney;
+	}
+
+	//puts back what was saved in a session snapshot
+	void RestoreSavedState(int _iChips, int _iCumulativeMoney, int _iErrors)
+	{
+		CurrentChips = _iChips;
+		CumulativeMoney = _iCumulativeMoney;
+		CumulativeInputErrors = _iErrors;
+	}
+
+private:
+	string LastInput; //used to store last input value, for reprinting and keeping UI tidy
+	string LastOutput; //used to store last output value, for reprinting and keeping UI tidy
+	int CumulativeInputErrors = 0; //counts input errors to allow casino security to warn user for repeated infractions
+	int CurrentChips = 0; //stores current value of chips the user has on the table
+	int CumulativeMoney = 0; //keeps track of how much money the user has spent or cashed out
+};
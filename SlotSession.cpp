@@ -0,0 +1,525 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SlotSession.cpp
+Description : A session at the slot machine - its menus, input checking, bets, payouts and buying chips - run
+              by both the console game and the headless session host
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+
+#include "SlotSession.h"
+#include "ProgressiveJackpot.h"
+#include "LivePaytable.h"
+
+//checks a line of input is a positive whole number and converts it.  Returns -1 and sets the error if it isn't.
+int ParseUserInput(const string& _strInput, EInputErrors* _pError)
+{
+	if (_strInput.empty())  //user pressed enter without any input first
+	{
+		*_pError = EInputErrors::NO_INPUT_GIVEN;
+		return -1;
+	}
+	else if (IsOnlyNumbers(_strInput))  //string to integer for valid numerical input
+	{
+		return stoi(_strInput);
+	}
+	else  //user entered non-numerical input value (includes . and - as non-valid)
+	{
+		*_pError = EInputErrors::NOT_NUMBER;
+		return -1;
+	}
+}
+
+//message shown to the user for each kind of input error
+string GetInputErrorMessage(EInputErrors _ErrCode)
+{
+	switch (_ErrCode)
+	{
+	case EInputErrors::NOT_NUMBER:
+		return "-----Please enter a positive whole number with no other characters-----\n\n  ";
+	case EInputErrors::NOT_ON_MENU:
+		return "-----Please enter a number that matches a menu option.-----\n\n  ";
+	case EInputErrors::INVALID_BET:
+		return "-----You can't bet more than you have.-----\n\n  ";
+	case EInputErrors::NO_INPUT_GIVEN:
+		return "-----You just hit enter without any input.-----\n\n  ";
+	case EInputErrors::WIN_TOO_BIG:
+		return "-----That bet could win more chips than you can hold.  Please bet less.-----\n\n  ";
+	default: //shouldn't be called, but in case of changes in future this will be picked up.
+		return "\n  Something unexpected happened.  See developer for more info.\n\n  ";
+	}
+}
+
+//prints a string to display how much money the user has made or lost today.
+//Takes a boolean argument to assess whether they are still playing or whether they are leaving casino now
+string DescribeCurrentPosition(bool _bStillPlaying, int _iMoney)
+{
+	string profitLossDescription = "You ";
+
+	//int temp = g_CumulativeSpendOrWin;
+	//temp += CurrentChips;
+
+	if (_iMoney == 0)
+	{
+		if (_bStillPlaying)
+		{
+			profitLossDescription += "are breaking";
+		}
+		else //if !stillplaying
+		{
+			profitLossDescription += "broke";
+		}
+
+		profitLossDescription += " even today, not bad.\n  ";
+		return profitLossDescription;  //should be "You are breaking even today, not bad." or "You broke even today, not bad."
+	}
+	else //if money != 0
+	{
+		if (_bStillPlaying)
+		{
+			profitLossDescription += "are making";
+		}
+		else //if !stillplaying
+		{
+			profitLossDescription += "made";
+		}
+	}
+
+	if (_iMoney < 0)
+	{
+		profitLossDescription += " an overall loss today of ";
+	}
+	else //if (money > 0).  == 0 won't occur because it was in the separate if statement above and has already been returned.
+	{
+		profitLossDescription += " overall winnings today of ";
+	}
+
+	profitLossDescription += std::to_string(_iMoney);
+	profitLossDescription += ".\n  ";
+	return profitLossDescription; //Should be "You are making/made an overal loss today of xxxx" or "You are making/made overall winnings today of xxxx"
+}
+
+//checks the player could hold everything a bet might win on a paytable - its biggest multiplier, or the jackpot multiplier
+//plus the progressive jackpot as it stands for a qualifying bet.  A bet that fails is turned away before it is placed,
+//so no win ever has to be cut short once it has been paid.
+bool CanPayBet(SlotMachineUser* _user, int _iBet, const SlotPaytable& _paytable)
+{
+	long long mostWinnable = (long long)_iBet * std::max(_paytable.TwoMatchMultiplier, _paytable.ThreeMatchMultiplier);
+	long long jackpotWin = (long long)_iBet * _paytable.JackpotMultiplier;
+	if (_iBet >= JACKPOT_QUALIFYING_BET)
+	{
+		jackpotWin += GetProgressiveJackpot().GetPoolChips();
+	}
+	mostWinnable = std::max(mostWinnable, jackpotWin);
+
+	long long chipsAfterBet = (long long)_user->GetChips() - _iBet;
+	return mostWinnable <= (long long)INT_MAX - chipsAfterBet;
+}
+
+//takes the bet off the player's chips, and gives the progressive jackpot its slice
+void PlaceBet(SlotMachineUser* _user, int _iBet)
+{
+	_user->AddChips(_iBet * -1); //subtract bet that was put in the slotmachine
+	GetProgressiveJackpot().Contribute(_iBet); //a slice of every bet goes to the progressive jackpot
+	return;
+}
+
+//works out what a spin won, including the progressive jackpot on three 7s for a qualifying bet, and adds it to the player's chips.
+//the bet has already passed CanPayBet on this paytable, so the multiplier win always fits.  The pool can still grow
+//from other players' bets between that check and the claim, so the claim is told how much room is left, and any
+//more than that stays in the pool.
+int PayWinnings(SlotMachineUser* _user, int _iBet, ESpinResultCode _eResult, const SlotPaytable& _paytable)
+{
+	long long winnings = (long long)_iBet * GetPayoutMultiplier(_paytable, _eResult);
+	if (_eResult == JACKPOT_THREE_SEVENS)
+	{
+		long long roomLeft = (long long)INT_MAX - _user->GetChips() - winnings;
+		winnings += GetProgressiveJackpot().ClaimJackpot(_iBet, nullptr, roomLeft);
+	}
+
+	_user->AddChips((int)winnings); //return any winnings to the player's pot
+	return (int)winnings;
+}
+
+//buys chips up to the most allowed at once, and returns how many were bought
+int BuyChips(SlotMachineUser* _user, int _iChipsRequested)
+{
+	int chipsBought = _iChipsRequested >= MAX_CHIP_PURCHASE ? MAX_CHIP_PURCHASE : _iChipsRequested;
+	_user->CashInOrOut(chipsBought);
+	return chipsBought;
+}
+
+//counts an input error against the user, and returns their total so far for casino security to check
+int RecordInputError(SlotMachineUser* _user)
+{
+	_user->AddError();
+	return _user->GetErrors();
+}
+
+//sits a new player down at the machine with some chips
+void StartSession(SlotSession* _session, int _iStartingChips)
+{
+	_session->User = SlotMachineUser();
+	_session->User.SetInput("Welcome to the GD1P01_22071 Mini Project: Slot Machine!");
+	_session->User.SetOutput("Please gamble wisely.");
+	_session->User.CashInOrOut(_iStartingChips);
+	for (int i = 0; i < REEL_COUNT; i++)
+	{
+		_session->User.LastSpin[i] = REEL_MAX_VALUE;
+	}
+	_session->State = ESessionState::AT_MENU;
+	_session->ResumeState = ESessionState::AT_MENU;
+	_session->LastEvent = ESessionEvent::NONE;
+	_session->SpinCount = 0;
+	_session->LastBet = 0;
+	_session->LastWinnings = 0;
+	_session->AutoPlay = AutoPlaySettings();
+	_session->AutoProgress = AutoPlayProgress();
+	return;
+}
+
+//counts bad input against the user, and lets security step in if it keeps happening
+static void HandleSessionInputError(SlotSession* _session, EInputErrors _ErrCode)
+{
+	_session->User.SetOutput(GetInputErrorMessage(_ErrCode));
+
+	int errors = RecordInputError(&_session->User);
+	if (errors == SECURITY_EXPEL_ERRORS)
+	{
+		_session->ExitCode = EExitCode::TOO_MANY_BAD_INPUTS;
+		_session->State = ESessionState::ENDED;
+	}
+	else if (errors == SECURITY_WARNING_ERRORS || errors == SECURITY_STERN_WARNING_ERRORS)
+	{
+		_session->ResumeState = _session->State;
+		_session->State = ESessionState::AWAITING_ACKNOWLEDGEMENT;
+	}
+	return;
+}
+
+//tells the user what a spin won, quoting the multiplier from the paytable it was played on
+static string DescribeSpinResult(ESpinResultCode _eResult, int _iBet, int _iWinnings, const SlotPaytable& _paytable)
+{
+	string tempStr = "";
+	switch (_eResult)
+	{
+	case LOSING_SPIN:
+		tempStr += "Sorry, you did not win this time.\n\n  ";
+		break;
+	case TWO_NUMS_MATCH:
+		tempStr += "You matched two numbers, and won " + std::to_string(_paytable.TwoMatchMultiplier) + " times your bet!\n  ";
+		break;
+	case THREE_NUMS_MATCH:
+		tempStr += "You matched three numbers, and won " + std::to_string(_paytable.ThreeMatchMultiplier) + " times your bet!\n  ";
+		break;
+	case JACKPOT_THREE_SEVENS:
+		tempStr += "You hit the jackpot and spun three 7s!  You won " + std::to_string(_paytable.JackpotMultiplier) + " times your bet";
+		if (_iBet >= JACKPOT_QUALIFYING_BET)
+		{
+			tempStr += ",\n  plus the progressive jackpot!\n  ";
+		}
+		else
+		{
+			tempStr += ".\n  Bet $" + std::to_string(JACKPOT_QUALIFYING_BET) + " or more to win the progressive jackpot too.\n  ";
+		}
+		break;
+	default:
+		tempStr += "Something unexpected happened, please contact the developer for more info\n  ";
+		break;
+	}
+
+	if (_eResult != LOSING_SPIN)
+	{
+		tempStr += "You receive $";
+		tempStr += std::to_string(_iWinnings);
+	}
+	return tempStr;
+}
+
+//spins the reels for a bet the player can afford, paying out straight away.  The bet is turned away instead if it
+//could win more than the player can hold.
+static void PlaySessionSpin(SlotSession* _session, int _iBet)
+{
+	//the whole spin is played on the paytable in place as it starts, even if a new one is loaded part way through
+	const SlotPaytable& paytable = BeginPaytableRead().Paytable;
+	if (!CanPayBet(&_session->User, _iBet, paytable))
+	{
+		HandleSessionInputError(_session, EInputErrors::WIN_TOO_BIG);
+		return;
+	}
+	PlaceBet(&_session->User, _iBet);
+	ESpinResultCode result = SpinReels(paytable, _session->User.LastSpin);
+	int winnings = PayWinnings(&_session->User, _iBet, result, paytable);
+	_session->SpinCount++;
+
+	_session->User.SetOutput(DescribeSpinResult(result, _iBet, winnings, paytable));
+	_session->LastBet = _iBet;
+	_session->LastWinnings = winnings;
+	_session->LastEvent = ESessionEvent::SPIN_PLAYED;
+
+	//asks whether to buy more as soon as the chips run out
+	_session->State = _session->User.GetChips() > 0 ? ESessionState::AT_MENU : ESessionState::AWAITING_TOP_UP_CHOICE;
+	return;
+}
+
+//sums up an auto play run once it stops, and goes back to the menu (or straight to buying more, if the chips ran out)
+static void FinishSessionAutoPlay(SlotSession* _session)
+{
+	const AutoPlayProgress& progress = _session->AutoProgress;
+	long long profit = progress.TotalWon - progress.TotalBet;
+	string tempStr = "Auto play played " + std::to_string(progress.SpinsPlayed) + " spins, winning " + std::to_string(progress.Wins)
+		+ " times.  " + DescribeAutoPlayStop(progress.StopReason) + "\n  ";
+	tempStr += "You bet $" + std::to_string(progress.TotalBet) + " and won $" + std::to_string(progress.TotalWon)
+		+ (profit >= 0 ? ", up $" : ", down $") + std::to_string(profit >= 0 ? profit : -profit) + ".\n  ";
+	_session->User.SetOutput(tempStr);
+
+	_session->State = _session->User.GetChips() > 0 ? ESessionState::AT_MENU : ESessionState::AWAITING_TOP_UP_CHOICE;
+	return;
+}
+
+//takes one line of input, exactly as the user typed it, and acts on it for whichever question the session is asking.
+//menus answer with one key, amounts with a line, a security warning is acknowledged with any input at all,
+//and while auto play runs any input stops it.  Whatever the user should see next is left in the user's output.
+void HandleSessionInput(SlotSession* _session, const string& _strInput)
+{
+	_session->LastEvent = ESessionEvent::NONE;
+	if (_session->State == ESessionState::ENDED)
+	{
+		return;
+	}
+	if (_session->State == ESessionState::AUTO_PLAYING) //the auto play line stays on screen with the summary under it
+	{
+		_session->AutoProgress.StopReason = EAutoPlayStop::CANCELLED;
+		FinishSessionAutoPlay(_session);
+		return;
+	}
+	if (_session->State == ESessionState::AWAITING_ACKNOWLEDGEMENT) //goes back to the question the warning interrupted
+	{
+		_session->State = _session->ResumeState;
+		return;
+	}
+
+	_session->User.SetInput(_strInput);
+	EInputErrors inputError = EInputErrors::NOT_NUMBER;
+	int value = ParseUserInput(_strInput, &inputError);
+	if (value < 0)
+	{
+		HandleSessionInputError(_session, inputError);
+		return;
+	}
+
+	SlotMachineUser* user = &_session->User;
+	switch (_session->State)
+	{
+	case ESessionState::AT_MENU:
+		switch (value)
+		{
+		case 1: //Play Slots
+			_session->State = ESessionState::AWAITING_BET;
+			break;
+		case 2: //Credits
+			user->SetOutput("This program was written by David Fransham, 2022\n  ");
+			_session->LastEvent = ESessionEvent::CREDITS_SHOWN;
+			break;
+		case 3: //Quit
+			_session->ExitCode = EExitCode::USER_CHOSE_QUIT;
+			_session->State = ESessionState::ENDED;
+			break;
+		case 4: //display profit tracker
+			user->SetOutput(DescribeCurrentPosition(true, user->GetFinancialPosition()));
+			break;
+		case 5: //Cash Out
+			_session->State = ESessionState::AWAITING_CASH_OUT;
+			break;
+		case 7: //Auto Play - lots of spins at one bet without coming back to the menu
+			_session->State = ESessionState::AWAITING_AUTO_SPIN_COUNT;
+			break;
+		case 6: //deposit more, only on the menu at or below the top up limit
+			if (user->GetChips() <= TOP_UP_CHIP_LIMIT)
+			{
+				_session->State = ESessionState::AWAITING_PURCHASE;
+				break; //falls through to default if 6 is not on the menu
+			}
+		default:
+			HandleSessionInputError(_session, EInputErrors::NOT_ON_MENU);
+			break;
+		}
+		break;
+
+	case ESessionState::AWAITING_BET:
+		if (value == 0) //user got cold feet and decided not to gamble just now
+		{
+			user->SetOutput("You have chosen to return to the previous menu.\n  ");
+			_session->State = ESessionState::AT_MENU;
+		}
+		else if (value > user->GetChips()) //User tried to bet more than they have available
+		{
+			HandleSessionInputError(_session, EInputErrors::INVALID_BET);
+		}
+		else
+		{
+			PlaySessionSpin(_session, value);
+		}
+		break;
+
+	case ESessionState::AWAITING_PURCHASE:
+	case ESessionState::AWAITING_TOP_UP_PURCHASE:
+		if (value >= MAX_CHIP_PURCHASE)
+		{
+			BuyChips(user, value);
+			user->SetOutput("You have purchased the maximum number of chips allowed, " + std::to_string(MAX_CHIP_PURCHASE) + ".\n  ");
+			_session->State = ESessionState::AT_MENU;
+		}
+		else if (value > 0)
+		{
+			user->SetOutput("You purchased $" + std::to_string(BuyChips(user, value)) + " more chips.\n  ");
+			_session->State = ESessionState::AT_MENU;
+		}
+		else if (_session->State == ESessionState::AWAITING_TOP_UP_PURCHASE) //out of chips and didn't buy any, so they leave
+		{
+			_session->ExitCode = EExitCode::OUT_OF_CHIPS;
+			_session->State = ESessionState::ENDED;
+		}
+		else
+		{
+			_session->State = ESessionState::AT_MENU;
+		}
+		break;
+
+	case ESessionState::AWAITING_CASH_OUT:
+		if (value == 0)
+		{
+			user->SetOutput("You chose to return to the casino without cashing anything out.\n  ");
+			_session->State = ESessionState::AT_MENU;
+		}
+		else if (value >= user->GetChips()) //cashing out every chip means leaving, and the chips are cashed out on the way
+		{
+			_session->ExitCode = EExitCode::USER_CHOSE_QUIT;
+			_session->State = ESessionState::ENDED;
+		}
+		else
+		{
+			user->CashInOrOut(value * -1);
+			user->SetOutput("You cashed out " + std::to_string(value) + " and return to the casino.\n  You still have " + std::to_string(user->GetChips()));
+			_session->State = ESessionState::AT_MENU;
+		}
+		break;
+
+	case ESessionState::AWAITING_TOP_UP_CHOICE:
+		if (value == 0)
+		{
+			_session->ExitCode = EExitCode::OUT_OF_CHIPS;
+			_session->State = ESessionState::ENDED;
+		}
+		else if (value == 1)
+		{
+			_session->State = ESessionState::AWAITING_TOP_UP_PURCHASE;
+		}
+		break; //any other number just asks again
+
+	case ESessionState::AWAITING_AUTO_SPIN_COUNT:
+		if (value == 0)
+		{
+			user->SetOutput("You have chosen to return to the previous menu.\n  ");
+			_session->State = ESessionState::AT_MENU;
+		}
+		else
+		{
+			_session->AutoPlay = AutoPlaySettings();
+			_session->AutoPlay.SpinCount = value;
+			_session->State = ESessionState::AWAITING_AUTO_BET;
+		}
+		break;
+
+	case ESessionState::AWAITING_AUTO_BET:
+		if (value == 0)
+		{
+			user->SetOutput("You have chosen to return to the previous menu.\n  ");
+			_session->State = ESessionState::AT_MENU;
+		}
+		else if (value > user->GetChips()) //User tried to bet more than they have available
+		{
+			HandleSessionInputError(_session, EInputErrors::INVALID_BET);
+		}
+		else if (!CanPayBet(user, value, BeginPaytableRead().Paytable))
+		{
+			HandleSessionInputError(_session, EInputErrors::WIN_TOO_BIG);
+		}
+		else
+		{
+			_session->AutoPlay.Bet = value;
+			_session->State = ESessionState::AWAITING_AUTO_BALANCE_FLOOR;
+		}
+		break;
+
+	case ESessionState::AWAITING_AUTO_BALANCE_FLOOR:
+		_session->AutoPlay.BalanceFloor = value;
+		_session->State = ESessionState::AWAITING_AUTO_WIN_LIMIT;
+		break;
+
+	case ESessionState::AWAITING_AUTO_WIN_LIMIT:
+		_session->AutoPlay.StopOnWinAbove = value;
+		_session->State = ESessionState::AWAITING_AUTO_JACKPOT_CHOICE;
+		break;
+
+	case ESessionState::AWAITING_AUTO_JACKPOT_CHOICE:
+		if (value > 1)
+		{
+			HandleSessionInputError(_session, EInputErrors::NOT_ON_MENU);
+		}
+		else
+		{
+			_session->AutoPlay.StopOnJackpot = value == 1;
+			_session->AutoProgress = AutoPlayProgress();
+			user->SetInput("Auto play: " + std::to_string(_session->AutoPlay.SpinCount) + " spins at $" + std::to_string(_session->AutoPlay.Bet)
+				+ ".  Press any key to stop.");
+			_session->State = ESessionState::AUTO_PLAYING;
+		}
+		break;
+
+	default:
+		break;
+	}
+	return;
+}
+
+//plays the next spin of a running auto play.  Returns false once the run has stopped, with the summary in the
+//user's output and the session back at the menu (or asking to buy more, if the chips ran out).
+bool PlaySessionAutoSpin(SlotSession* _session)
+{
+	if (_session->State != ESessionState::AUTO_PLAYING)
+	{
+		return false;
+	}
+
+	int spinsBefore = _session->AutoProgress.SpinsPlayed;
+	bool keepPlaying = PlayAutoSpin(&_session->User, _session->AutoPlay, &_session->AutoProgress);
+	_session->SpinCount += _session->AutoProgress.SpinsPlayed - spinsBefore;
+	if (!keepPlaying)
+	{
+		FinishSessionAutoPlay(_session);
+	}
+	return keepPlaying;
+}
+
+//This function takes a string as input, uses std::isdigit to loop through the stringand check if any digits are not numbers.
+bool IsOnlyNumbers(const string& str)
+{
+	for (char const& c : str)
+	{
+		if (std::isdigit(c) == 0) return false;
+	}
+	return true;
+}
+//onlyNumbers is borrowed and adapted from :
+//https://www.delftstack.com/howto/cpp/how-to-determine-if-a-string-is-number-cpp/
+//Limitations: checks each character for 0 - 9, so doesn't recognise decimal point or - as numbers.
+//Therefore only works for positive whole numbers.
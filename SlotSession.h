@@ -0,0 +1,103 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SlotSession.h
+Description : A session at the slot machine - its menus, input checking, bets, payouts and buying chips - run
+              by both the console game and the headless session host
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <string>
+
+#include "AutoPlay.h"
+#include "SlotEngine.h"
+#include "SlotMachineUser.h"
+
+using std::string;
+
+enum class EExitCode
+{
+	OUT_OF_CHIPS,
+	USER_CHOSE_QUIT,
+	TOO_MANY_BAD_INPUTS,
+};
+
+enum class EInputErrors
+{
+	NOT_NUMBER,
+	NOT_ON_MENU,
+	INVALID_BET,
+	NO_INPUT_GIVEN,
+	WIN_TOO_BIG, //the bet could win more chips than the player can hold
+};
+
+const int STARTING_CHIPS = 2000; //chips a new player buys when they sit down
+const int MAX_CHIP_PURCHASE = 5000; //most chips that can be bought at once
+const int TOP_UP_CHIP_LIMIT = 500; //buying more chips is only on the menu at or below this many chips
+const int SECURITY_WARNING_ERRORS = 4; //input errors before security have a polite word
+const int SECURITY_STERN_WARNING_ERRORS = 8; //input errors before security have a stern word
+const int SECURITY_EXPEL_ERRORS = 10; //input errors before security escort the player out
+
+//where a session is up to - which question it is waiting for an answer to.  Saved in snapshots as a number,
+//so new states go on the end.
+enum class ESessionState
+{
+	AT_MENU,
+	AWAITING_BET,
+	AWAITING_PURCHASE,
+	AWAITING_CASH_OUT,
+	AWAITING_TOP_UP_CHOICE, //ran out of chips, asked whether to buy more
+	AWAITING_TOP_UP_PURCHASE, //ran out of chips, said yes, asked how many
+	AWAITING_ACKNOWLEDGEMENT, //security warning on screen, waiting for a key
+	ENDED,
+	AWAITING_AUTO_SPIN_COUNT, //the auto play questions, in the order they are asked
+	AWAITING_AUTO_BET,
+	AWAITING_AUTO_BALANCE_FLOOR,
+	AWAITING_AUTO_WIN_LIMIT,
+	AWAITING_AUTO_JACKPOT_CHOICE,
+	AUTO_PLAYING, //spins are played with PlaySessionAutoSpin, and any input stops them
+};
+
+//anything the last input did that a front end might want to show more of than the output line
+enum class ESessionEvent
+{
+	NONE,
+	SPIN_PLAYED, //the reels in User.LastSpin were spun for LastBet and paid LastWinnings
+	CREDITS_SHOWN,
+};
+
+//a player's session.  Input goes in a line at a time, exactly as it was typed, and HandleSessionInput decides what
+//happens - both the console game and the load test's virtual players are run this way.
+struct SlotSession
+{
+	SlotMachineUser User;
+	ESessionState State = ESessionState::AT_MENU;
+	ESessionState ResumeState = ESessionState::AT_MENU; //where to go back to after a security warning
+	EExitCode ExitCode = EExitCode::USER_CHOSE_QUIT; //why the session ended, once State is ENDED
+	ESessionEvent LastEvent = ESessionEvent::NONE;
+	long long SpinCount = 0;
+	int LastBet = 0;
+	int LastWinnings = 0;
+	AutoPlaySettings AutoPlay; //filled in as the auto play questions are answered
+	AutoPlayProgress AutoProgress;
+};
+
+bool IsOnlyNumbers(const string& _str);
+int ParseUserInput(const string& _strInput, EInputErrors* _pError);
+string GetInputErrorMessage(EInputErrors _ErrCode);
+string DescribeCurrentPosition(bool _bStillPlaying, int _iMoney);
+bool CanPayBet(SlotMachineUser* _user, int _iBet, const SlotPaytable& _paytable);
+void PlaceBet(SlotMachineUser* _user, int _iBet);
+int PayWinnings(SlotMachineUser* _user, int _iBet, ESpinResultCode _eResult, const SlotPaytable& _paytable);
+int BuyChips(SlotMachineUser* _user, int _iChipsRequested);
+int RecordInputError(SlotMachineUser* _user);
+
+void StartSession(SlotSession* _session, int _iStartingChips = STARTING_CHIPS);
+void HandleSessionInput(SlotSession* _session, const string& _strInput);
+bool PlaySessionAutoSpin(SlotSession* _session);
@@ -0,0 +1,293 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SpinExport.cpp
+Description : Compact column-by-column binary file of every spin in a simulation, and a memory-mapped reader for it
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <cstring>
+
+#include "SpinExport.h"
+
+//result codes are stored as a 2 bit index rather than their multiplier value
+static const ESpinResultCode RESULT_FROM_INDEX[4] = { LOSING_SPIN, TWO_NUMS_MATCH, THREE_NUMS_MATCH, JACKPOT_THREE_SEVENS };
+
+//turns a result code into its 2 bit index for the reels column
+static uint32_t GetResultIndex(ESpinResultCode _eResult)
+{
+	switch (_eResult)
+	{
+	case TWO_NUMS_MATCH:
+		return 1;
+	case THREE_NUMS_MATCH:
+		return 2;
+	case JACKPOT_THREE_SEVENS:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+//appends a number 7 bits at a time, with the top bit of each byte set if more bytes follow
+static inline void WriteVarint(std::vector<uint8_t>& _column, uint64_t _iValue)
+{
+	while (_iValue >= 0x80)
+	{
+		_column.push_back((uint8_t)(_iValue | 0x80));
+		_iValue >>= 7;
+	}
+	_column.push_back((uint8_t)_iValue);
+}
+
+//reads a number written by WriteVarint, moving the cursor past it.  Returns false if the column ends part way through.
+static inline bool ReadVarint(const uint8_t*& _pCursor, const uint8_t* _pEnd, uint64_t& _iValue)
+{
+	_iValue = 0;
+	for (int shift = 0; shift < 64 && _pCursor < _pEnd; shift += 7)
+	{
+		uint8_t byte = *_pCursor++;
+		_iValue |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//zigzag encoding maps small negative numbers to small positive ones (0, -1, 1, -2 ... becomes 0, 1, 2, 3 ...) so they stay short as varints
+static inline uint64_t ZigzagEncode(int64_t _iValue)
+{
+	return ((uint64_t)_iValue << 1) ^ (uint64_t)(_iValue >> 63);
+}
+
+static inline int64_t ZigzagDecode(uint64_t _iValue)
+{
+	return (int64_t)(_iValue >> 1) ^ -(int64_t)(_iValue & 1);
+}
+
+SpinExportWriter::~SpinExportWriter()
+{
+	Close();
+}
+
+//creates the file and writes a placeholder header, which is filled in properly on Close
+bool SpinExportWriter::Open(const std::string& _strFileName, int64_t _iStartBalance)
+{
+	File.open(_strFileName, std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	StartBalance = _iStartBalance;
+	LastBalance = _iStartBalance;
+	BlockStartBalance = _iStartBalance;
+	BlockSpins = 0;
+	BlockCount = 0;
+	SpinCount = 0;
+
+	ReelColumn.reserve(SPIN_EXPORT_BLOCK_SPINS * 2);
+	BetColumn.reserve(SPIN_EXPORT_BLOCK_SPINS * 5);
+	PayoutColumn.reserve(SPIN_EXPORT_BLOCK_SPINS * 5);
+	BalanceColumn.reserve(SPIN_EXPORT_BLOCK_SPINS * 10);
+
+	SpinExportFileHeader header = {};
+	File.write((const char*)&header, sizeof(header));
+	return File.good();
+}
+
+//adds one spin to the current block, writing the block out once it is full
+void SpinExportWriter::AddSpin(const int _iSlotNums[REEL_COUNT], ESpinResultCode _eResult, uint64_t _iBet, uint64_t _iPayout, int64_t _iBalanceAfter)
+{
+	uint32_t packed = (uint32_t)_iSlotNums[0] | ((uint32_t)_iSlotNums[1] << 3) | ((uint32_t)_iSlotNums[2] << 6) | (GetResultIndex(_eResult) << 9);
+	ReelColumn.push_back((uint8_t)packed);
+	ReelColumn.push_back((uint8_t)(packed >> 8));
+
+	WriteVarint(BetColumn, _iBet);
+	WriteVarint(PayoutColumn, _iPayout);
+	WriteVarint(BalanceColumn, ZigzagEncode(_iBalanceAfter - LastBalance));
+	LastBalance = _iBalanceAfter;
+
+	BlockSpins++;
+	SpinCount++;
+	if (BlockSpins == SPIN_EXPORT_BLOCK_SPINS)
+	{
+		WriteBlock();
+	}
+}
+
+//writes the block header and each column in one go, then starts a new block
+bool SpinExportWriter::WriteBlock()
+{
+	if (BlockSpins == 0)
+	{
+		return true;
+	}
+
+	SpinExportBlockHeader header = {};
+	header.SpinCount = BlockSpins;
+	header.ReelBytes = (uint32_t)ReelColumn.size();
+	header.BetBytes = (uint32_t)BetColumn.size();
+	header.PayoutBytes = (uint32_t)PayoutColumn.size();
+	header.BalanceBytes = (uint32_t)BalanceColumn.size();
+	header.StartBalance = BlockStartBalance;
+
+	File.write((const char*)&header, sizeof(header));
+	File.write((const char*)ReelColumn.data(), ReelColumn.size());
+	File.write((const char*)BetColumn.data(), BetColumn.size());
+	File.write((const char*)PayoutColumn.data(), PayoutColumn.size());
+	File.write((const char*)BalanceColumn.data(), BalanceColumn.size());
+
+	ReelColumn.clear();
+	BetColumn.clear();
+	PayoutColumn.clear();
+	BalanceColumn.clear();
+	BlockSpins = 0;
+	BlockStartBalance = LastBalance;
+	BlockCount++;
+	return File.good();
+}
+
+//writes out the last part-filled block and goes back to fill in the file header
+bool SpinExportWriter::Close()
+{
+	if (!File.is_open())
+	{
+		return true;
+	}
+
+	bool isGood = WriteBlock();
+
+	SpinExportFileHeader header = {};
+	std::memcpy(header.Magic, "SLOTSPIN", sizeof(header.Magic));
+	header.Version = SPIN_EXPORT_VERSION;
+	header.BlockCount = BlockCount;
+	header.SpinCount = SpinCount;
+	header.StartBalance = StartBalance;
+	File.seekp(0);
+	File.write((const char*)&header, sizeof(header));
+
+	isGood = isGood && File.good();
+	File.close();
+	return isGood;
+}
+
+SpinExportReader::~SpinExportReader()
+{
+	Close();
+}
+
+//maps the whole file into memory and checks the header
+bool SpinExportReader::Open(const std::string& _strFileName)
+{
+	Close();
+
+	if (!File.Open(_strFileName, sizeof(SpinExportFileHeader)))
+	{
+		return false;
+	}
+
+	Header = (const SpinExportFileHeader*)File.GetData();
+	if (std::memcmp(Header->Magic, "SLOTSPIN", sizeof(Header->Magic)) != 0 || Header->Version != SPIN_EXPORT_VERSION)
+	{
+		Close();
+		return false;
+	}
+
+	NextBlockStart = File.GetData() + sizeof(SpinExportFileHeader);
+	CurrentBlock = SpinExportBlock();
+	SpinInBlock = 0;
+	CurrentBalance = Header->StartBalance;
+	return true;
+}
+
+//unmaps the file
+void SpinExportReader::Close()
+{
+	File.Close();
+	Header = nullptr;
+	NextBlockStart = nullptr;
+	return;
+}
+
+//points the block at the next set of columns in the file.  Returns false at the end of the file, or if the block is damaged.
+bool SpinExportReader::NextBlock(SpinExportBlock& _block)
+{
+	if (File.GetData() == nullptr)
+	{
+		return false;
+	}
+
+	const uint8_t* fileEnd = File.GetData() + File.GetSize();
+	if ((uint64_t)(fileEnd - NextBlockStart) < sizeof(SpinExportBlockHeader))
+	{
+		return false;
+	}
+
+	SpinExportBlockHeader header;
+	std::memcpy(&header, NextBlockStart, sizeof(header));
+	uint64_t columnBytes = (uint64_t)header.ReelBytes + header.BetBytes + header.PayoutBytes + header.BalanceBytes;
+	const uint8_t* columns = NextBlockStart + sizeof(header);
+	if ((uint64_t)(fileEnd - columns) < columnBytes || header.ReelBytes != header.SpinCount * 2)
+	{
+		return false;
+	}
+
+	_block.SpinCount = header.SpinCount;
+	_block.StartBalance = header.StartBalance;
+	_block.Reels = columns;
+	_block.Bets = _block.Reels + header.ReelBytes;
+	_block.Payouts = _block.Bets + header.BetBytes;
+	_block.BalanceDeltas = _block.Payouts + header.PayoutBytes;
+	_block.End = _block.BalanceDeltas + header.BalanceBytes;
+
+	NextBlockStart = _block.End;
+	return true;
+}
+
+//decodes the next spin in the file.  Returns false once every spin has been read.
+bool SpinExportReader::NextSpin(SpinRecord& _record)
+{
+	while (SpinInBlock == CurrentBlock.SpinCount)
+	{
+		if (!NextBlock(CurrentBlock))
+		{
+			return false;
+		}
+		SpinInBlock = 0;
+		CurrentBalance = CurrentBlock.StartBalance;
+		ReelCursor = CurrentBlock.Reels;
+		BetCursor = CurrentBlock.Bets;
+		PayoutCursor = CurrentBlock.Payouts;
+		BalanceCursor = CurrentBlock.BalanceDeltas;
+	}
+
+	uint32_t packed = (uint32_t)ReelCursor[0] | ((uint32_t)ReelCursor[1] << 8);
+	ReelCursor += 2;
+	_record.SlotNums[0] = packed & 7;
+	_record.SlotNums[1] = (packed >> 3) & 7;
+	_record.SlotNums[2] = (packed >> 6) & 7;
+	_record.Result = RESULT_FROM_INDEX[(packed >> 9) & 3];
+
+	//the columns are back to back, so each one ends where the next begins
+	uint64_t bet, payout, delta;
+	if (!ReadVarint(BetCursor, CurrentBlock.Payouts, bet)
+		|| !ReadVarint(PayoutCursor, CurrentBlock.BalanceDeltas, payout)
+		|| !ReadVarint(BalanceCursor, CurrentBlock.End, delta))
+	{
+		return false;
+	}
+	_record.Bet = bet;
+	_record.Payout = payout;
+	CurrentBalance += ZigzagDecode(delta);
+	_record.Balance = CurrentBalance;
+
+	SpinInBlock++;
+	return true;
+}
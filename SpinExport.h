@@ -0,0 +1,135 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SpinExport.h
+Description : Compact column-by-column binary file of every spin in a simulation, and a memory-mapped reader for it
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "SlotEngine.h"
+#include "SystemHelpers.h"
+
+//File layout (all numbers little endian):
+//  file header  - "SLOTSPIN", version, block count, spin count, starting balance
+//  then blocks of up to SPIN_EXPORT_BLOCK_SPINS spins, each one:
+//    block header - spin count, byte length of each column, balance before the first spin
+//    reels column   - 2 bytes per spin: three 3 bit reel values, then a 2 bit result index
+//    bets column    - varint per spin, up to 64 bits
+//    payouts column - varint per spin, up to 64 bits
+//    balance column - zigzag varint per spin, the change in balance from the spin before
+
+const uint32_t SPIN_EXPORT_VERSION = 1;
+const int SPIN_EXPORT_BLOCK_SPINS = 1 << 16;
+
+#pragma pack(push, 1)
+struct SpinExportFileHeader
+{
+	char Magic[8]; //"SLOTSPIN"
+	uint32_t Version;
+	uint32_t BlockCount;
+	uint64_t SpinCount;
+	int64_t StartBalance;
+};
+
+struct SpinExportBlockHeader
+{
+	uint32_t SpinCount;
+	uint32_t ReelBytes;
+	uint32_t BetBytes;
+	uint32_t PayoutBytes;
+	uint32_t BalanceBytes;
+	uint32_t Reserved;
+	int64_t StartBalance; //balance before the first spin in the block, so blocks can be read on their own
+};
+#pragma pack(pop)
+
+//one spin, decoded
+struct SpinRecord
+{
+	int SlotNums[REEL_COUNT] = { 0,0,0 };
+	ESpinResultCode Result = LOSING_SPIN;
+	uint64_t Bet = 0;
+	uint64_t Payout = 0;
+	int64_t Balance = 0; //balance after the spin
+};
+
+//one block of the file, pointing straight into the mapped file.  Columns can be scanned on their own
+//(e.g. just the reels) without decoding the rest.
+struct SpinExportBlock
+{
+	uint32_t SpinCount = 0;
+	int64_t StartBalance = 0;
+	const uint8_t* Reels = nullptr;
+	const uint8_t* Bets = nullptr;
+	const uint8_t* Payouts = nullptr;
+	const uint8_t* BalanceDeltas = nullptr;
+	const uint8_t* End = nullptr;
+};
+
+//streams spins to a file, buffering a block's worth of each column and writing them out in large chunks
+class SpinExportWriter
+{
+public:
+	~SpinExportWriter();
+
+	bool Open(const std::string& _strFileName, int64_t _iStartBalance);
+	void AddSpin(const int _iSlotNums[REEL_COUNT], ESpinResultCode _eResult, uint64_t _iBet, uint64_t _iPayout, int64_t _iBalanceAfter);
+	bool Close();
+
+	uint64_t GetSpinCount() const { return SpinCount; }
+
+private:
+	bool WriteBlock();
+
+	std::ofstream File;
+	std::vector<uint8_t> ReelColumn;
+	std::vector<uint8_t> BetColumn;
+	std::vector<uint8_t> PayoutColumn;
+	std::vector<uint8_t> BalanceColumn;
+	uint32_t BlockSpins = 0;
+	int64_t BlockStartBalance = 0;
+	int64_t LastBalance = 0;
+	int64_t StartBalance = 0;
+	uint32_t BlockCount = 0;
+	uint64_t SpinCount = 0;
+};
+
+//reads a spin export by memory mapping the whole file, nothing is copied out of it until a spin is decoded
+class SpinExportReader
+{
+public:
+	~SpinExportReader();
+
+	bool Open(const std::string& _strFileName);
+	void Close();
+
+	bool NextBlock(SpinExportBlock& _block);
+	bool NextSpin(SpinRecord& _record);
+
+	uint64_t GetSpinCount() const { return Header ? Header->SpinCount : 0; }
+	int64_t GetStartBalance() const { return Header ? Header->StartBalance : 0; }
+
+private:
+	MappedFile File;
+	const SpinExportFileHeader* Header = nullptr;
+
+	const uint8_t* NextBlockStart = nullptr; //where NextBlock will look next
+	SpinExportBlock CurrentBlock; //block NextSpin is working through
+	const uint8_t* ReelCursor = nullptr; //next spin's position in each of CurrentBlock's columns
+	const uint8_t* BetCursor = nullptr;
+	const uint8_t* PayoutCursor = nullptr;
+	const uint8_t* BalanceCursor = nullptr;
+	uint32_t SpinInBlock = 0;
+	int64_t CurrentBalance = 0;
+};
@@ -0,0 +1,105 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SystemHelpers.cpp
+Description : Small pieces of system code shared by the game's modes
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#include <windows.h>
+#include <cstdlib>
+#include <thread>
+
+#include "SystemHelpers.h"
+
+//how many worker threads to run.  0 or less means one for every core, and at least one if the core count is unknown.
+int GetWorkerThreadCount(int _iThreadCount)
+{
+	if (_iThreadCount > 0)
+	{
+		return _iThreadCount;
+	}
+	_iThreadCount = (int)std::thread::hardware_concurrency();
+	if (_iThreadCount <= 0) //hardware_concurrency can return 0 if it can't tell
+	{
+		_iThreadCount = 1;
+	}
+	return _iThreadCount;
+}
+
+//runs a clean up function when the game exits.  The game leaves through exit() in several places, so anything that
+//has to be undone on the way out, like stopping a background thread, is registered here to happen whichever way it goes.
+void CleanUpAtExit(void (*_pCleanUp)())
+{
+	std::atexit(_pCleanUp);
+	return;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//maps the whole file into memory.  Returns false if it can't be opened or is shorter than the minimum size.
+bool MappedFile::Open(const std::string& _strFileName, uint64_t _iMinimumSize)
+{
+	Close();
+
+	HANDLE file = CreateFileA(_strFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	FileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (uint64_t)fileSize.QuadPart < _iMinimumSize)
+	{
+		Close();
+		return false;
+	}
+	Size = (uint64_t)fileSize.QuadPart;
+
+	MappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (MappingHandle == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	Data = (const uint8_t*)MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (Data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+//unmaps the file and closes the handles
+void MappedFile::Close()
+{
+	if (Data != nullptr)
+	{
+		UnmapViewOfFile(Data);
+	}
+	if (MappingHandle != nullptr)
+	{
+		CloseHandle(MappingHandle);
+	}
+	if (FileHandle != nullptr)
+	{
+		CloseHandle(FileHandle);
+	}
+
+	FileHandle = nullptr;
+	MappingHandle = nullptr;
+	Data = nullptr;
+	Size = 0;
+	return;
+}
+
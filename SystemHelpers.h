@@ -0,0 +1,38 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+(c) 2022 Media Design School
+File Name : SystemHelpers.h
+Description : Small pieces of system code shared by the game's modes
+Author : David Fransham
+Mail : david.fransham@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+int GetWorkerThreadCount(int _iThreadCount);
+void CleanUpAtExit(void (*_pCleanUp)());
+
+//a whole file mapped read-only into memory, for the readers that decode straight out of it
+class MappedFile
+{
+public:
+	~MappedFile();
+
+	bool Open(const std::string& _strFileName, uint64_t _iMinimumSize);
+	void Close();
+
+	const uint8_t* GetData() const { return Data; }
+	uint64_t GetSize() const { return Size; }
+
+private:
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+	const uint8_t* Data = nullptr;
+	uint64_t Size = 0;
+};